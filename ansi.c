@@ -0,0 +1,183 @@
+#define _XOPEN_SOURCE 700
+
+#include "ansi.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "validate.h"
+
+// Worst case bytes per cell: an absolute cursor move plus a glyph of
+// ANSI_GLYPH_LEN four byte code points
+#define ANSI_CELL_BYTES (16 + 4 * ANSI_GLYPH_LEN)
+
+// Resets the attributes and selects the game's white on black
+#define ANSI_COLORS "\x1b[0;37;40m"
+
+static void blank_cell(AnsiCell* cell) {
+  memset(cell, 0, sizeof(*cell));
+  cell->text[0] = L' ';
+  cell->width = 1;
+}
+
+void ansi_init(AnsiScreen* screen, int fd, int x, int y, int w, int h) {
+  screen->x = x;
+  screen->y = y;
+  screen->w = w;
+  screen->h = h;
+  screen->fd = fd;
+
+  size_t cells = (size_t)w * h;
+  screen->front = malloc(sizeof(AnsiCell) * (cells + 1));
+  screen->back = malloc(sizeof(AnsiCell) * (cells + 1));
+  VALIDATE(screen->front);
+  VALIDATE(screen->back);
+
+  screen->out_capacity = cells * ANSI_CELL_BYTES + sizeof(ANSI_COLORS);
+  screen->out = malloc(screen->out_capacity);
+  VALIDATE(screen->out);
+
+  ansi_clear(screen);
+  ansi_invalidate(screen);
+}
+
+void ansi_free(AnsiScreen* screen) {
+  free(screen->front);
+  free(screen->back);
+  free(screen->out);
+  memset(screen, 0, sizeof(*screen));
+}
+
+void ansi_clear(AnsiScreen* screen) {
+  for (int i = 0; i < screen->w * screen->h; i++) {
+    blank_cell(&screen->back[i]);
+  }
+}
+
+void ansi_put(AnsiScreen* screen, int y, int x, const wchar_t* glyph,
+              int width) {
+  if (y < 0 || y >= screen->h || x < 0 || x + width > screen->w ||
+      width < 1) {
+    return;
+  }
+
+  AnsiCell* row = screen->back + (size_t)y * screen->w;
+
+  // Covering half of a wide glyph wipes the other half on the terminal too
+  if (row[x].width == 0 && x > 0) {
+    blank_cell(&row[x - 1]);
+  }
+  int end = x + width;
+  if (end < screen->w && row[end].width == 0) {
+    blank_cell(&row[end]);
+  }
+
+  AnsiCell* cell = &row[x];
+  memset(cell, 0, sizeof(*cell));
+  for (int i = 0; i < ANSI_GLYPH_LEN && glyph[i]; i++) {
+    cell->text[i] = glyph[i];
+  }
+  cell->width = width;
+
+  if (width == 2) {
+    memset(&row[x + 1], 0, sizeof(AnsiCell));
+  }
+}
+
+void ansi_text(AnsiScreen* screen, int y, int x, const char* text) {
+  wchar_t glyph[2] = {0, 0};
+  for (int i = 0; text[i]; i++) {
+    glyph[0] = (unsigned char)text[i];
+    ansi_put(screen, y, x + i, glyph, 1);
+  }
+}
+
+void ansi_invalidate(AnsiScreen* screen) { screen->front_valid = 0; }
+
+// Appends the UTF-8 encoding of a glyph
+static char* put_utf8(char* out, const wchar_t* text) {
+  for (int i = 0; i < ANSI_GLYPH_LEN && text[i]; i++) {
+    uint32_t c = (uint32_t)text[i];
+    if (c < 0x80) {
+      *out++ = (char)c;
+    } else if (c < 0x800) {
+      *out++ = (char)(0xc0 | (c >> 6));
+      *out++ = (char)(0x80 | (c & 0x3f));
+    } else if (c < 0x10000) {
+      *out++ = (char)(0xe0 | (c >> 12));
+      *out++ = (char)(0x80 | ((c >> 6) & 0x3f));
+      *out++ = (char)(0x80 | (c & 0x3f));
+    } else {
+      *out++ = (char)(0xf0 | (c >> 18));
+      *out++ = (char)(0x80 | ((c >> 12) & 0x3f));
+      *out++ = (char)(0x80 | ((c >> 6) & 0x3f));
+      *out++ = (char)(0x80 | (c & 0x3f));
+    }
+  }
+  return out;
+}
+
+size_t ansi_present(AnsiScreen* screen) {
+  char* out = screen->out;
+  int cursor_y = -1;
+  int cursor_x = -1;
+
+  for (int y = 0; y < screen->h; y++) {
+    for (int x = 0; x < screen->w; x++) {
+      size_t i = (size_t)y * screen->w + x;
+      const AnsiCell* back = &screen->back[i];
+      if (back->width == 0) {
+        continue;  // sent along with the left half
+      }
+
+      int cells = back->width;
+      if (screen->front_valid &&
+          memcmp(back, &screen->front[i], sizeof(AnsiCell) * cells) == 0) {
+        continue;
+      }
+
+      if (out == screen->out) {
+        memcpy(out, ANSI_COLORS, sizeof(ANSI_COLORS) - 1);
+        out += sizeof(ANSI_COLORS) - 1;
+      }
+
+      // A short forward jump on the same row is cheaper than an absolute
+      // move
+      if (cursor_y != y || cursor_x != x) {
+        if (cursor_y == y && x > cursor_x) {
+          out += sprintf(out, "\x1b[%dC", x - cursor_x);
+        } else {
+          out += sprintf(out, "\x1b[%d;%dH", screen->y + y + 1,
+                         screen->x + x + 1);
+        }
+      }
+
+      out = put_utf8(out, back->text);
+      memcpy(&screen->front[i], back, sizeof(AnsiCell) * cells);
+
+      // After the last column the terminal may hold the cursor or wrap it,
+      // the next cell gets an absolute move either way
+      cursor_y = x + cells < screen->w ? y : -1;
+      cursor_x = x + cells;
+    }
+  }
+  screen->front_valid = 1;
+
+  // The whole frame in one write, only repeated if the terminal takes part
+  size_t len = out - screen->out;
+  size_t sent = 0;
+  while (sent < len) {
+    ssize_t n = write(screen->fd, screen->out + sent, len - sent);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    sent += n;
+  }
+  return len;
+}
@@ -0,0 +1,62 @@
+#ifndef ANSI_H
+#define ANSI_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <wchar.h>
+
+// Longest glyph a cell holds, in code points (an emoji plus a variation
+// selector fits)
+#define ANSI_GLYPH_LEN 3
+
+// One terminal cell. A glyph two cells wide lives in its left cell, the cell
+// to its right is a continuation with width 0.
+typedef struct {
+  wchar_t text[ANSI_GLYPH_LEN + 1];
+  int width;
+} AnsiCell;
+
+// Draws into a back buffer of cells and sends only the cells that differ
+// from the front buffer, what the terminal shows, as cursor moves and UTF-8
+// glyphs. A frame is assembled in a preallocated buffer and goes out with a
+// single write().
+typedef struct {
+  int x;  // terminal column and row of the top left cell
+  int y;
+  int w;
+  int h;
+
+  AnsiCell* front;
+  AnsiCell* back;
+  int front_valid;  // 0 when the terminal content is unknown
+
+  char* out;
+  size_t out_capacity;
+  int fd;
+} AnsiScreen;
+
+// Sets up a screen of w x h cells shown at terminal column x, row y
+void ansi_init(AnsiScreen* screen, int fd, int x, int y, int w, int h);
+
+void ansi_free(AnsiScreen* screen);
+
+// Blanks the whole back buffer
+void ansi_clear(AnsiScreen* screen);
+
+// Puts a glyph of the given display width (1 or 2) at row y, column x.
+// Glyphs that would stick out of the screen are clipped.
+void ansi_put(AnsiScreen* screen, int y, int x, const wchar_t* glyph,
+              int width);
+
+// Puts a line of ASCII text starting at row y, column x
+void ansi_text(AnsiScreen* screen, int y, int x, const char* text);
+
+// Forgets what the terminal shows, e.g. after something else drew on it, so
+// the next frame repaints every cell
+void ansi_invalidate(AnsiScreen* screen);
+
+// Sends the changed cells to the terminal with one write(), returns the
+// number of bytes written
+size_t ansi_present(AnsiScreen* screen);
+
+#endif
@@ -0,0 +1,151 @@
+#include "arena.h"
+
+#include <errno.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "validate.h"
+
+#define ARENA_ALIGN alignof(max_align_t)
+
+// The usable bytes of a block follow its header
+#define BLOCK_HEADER \
+  ((sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+static ArenaBlock* new_block(size_t size, ArenaBlock* next) {
+  ArenaBlock* block = malloc(BLOCK_HEADER + size);
+  VALIDATE(block);
+  block->next = next;
+  block->size = size;
+  block->used = 0;
+  return block;
+}
+
+void arena_init(Arena* arena, size_t size) {
+  arena->head = size > 0 ? new_block(size, NULL) : NULL;
+}
+
+void arena_free(Arena* arena) {
+  ArenaBlock* block = arena->head;
+  while (block) {
+    ArenaBlock* next = block->next;
+    free(block);
+    block = next;
+  }
+  arena->head = NULL;
+}
+
+void arena_reset(Arena* arena) {
+  if (arena->head == NULL) {
+    return;
+  }
+  if (arena->head->next == NULL) {
+    arena->head->used = 0;
+    return;
+  }
+
+  // Whatever spilled into more blocks gets one that holds all of it
+  size_t total = 0;
+  for (ArenaBlock* block = arena->head; block; block = block->next) {
+    total += block->size;
+  }
+  arena_free(arena);
+  arena->head = new_block(total, NULL);
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+  size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+  ArenaBlock* block = arena->head;
+  if (block == NULL || block->size - block->used < size) {
+    // At least double, so a round that keeps spilling does not chain on a
+    // block per allocation
+    size_t grow = block ? block->size * 2 : 0;
+    block = new_block(size > grow ? size : grow, block);
+    arena->head = block;
+  }
+
+  void* ptr = (char*)block + BLOCK_HEADER + block->used;
+  block->used += size;
+  return ptr;
+}
+
+void* arena_calloc(Arena* arena, size_t count, size_t size) {
+  void* ptr = arena_alloc(arena, count * size);
+  memset(ptr, 0, count * size);
+  return ptr;
+}
+
+size_t arena_used(const Arena* arena) {
+  size_t used = 0;
+  for (ArenaBlock* block = arena->head; block; block = block->next) {
+    used += block->used;
+  }
+  return used;
+}
+
+#ifdef COUNT_ALLOCS
+
+// glibc's own entry points, the wrappers below take the public names
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+static atomic_ullong allocations;
+
+void* malloc(size_t size) {
+  atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+  if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+  void* block = __libc_memalign(alignment, size);
+  if (block == NULL) {
+    return ENOMEM;
+  }
+  *ptr = block;
+  return 0;
+}
+
+uint64_t heap_allocations(void) {
+  return atomic_load_explicit(&allocations, memory_order_relaxed);
+}
+
+void check_no_allocations(uint64_t since, const char* unit, long n) {
+  uint64_t made = heap_allocations() - since;
+  if (made == 0) {
+    return;
+  }
+
+  if (game_on_fatal) {
+    game_on_fatal();
+  }
+  fprintf(stderr, "Error: %s %ld allocated %llu times\n", unit, n,
+          (unsigned long long)made);
+  abort();
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator for memory that lives and dies together, such as everything
+// a round of the game uses. An allocation is a pointer bump and the whole
+// arena is released or reset at once. A block that runs out gets another one
+// chained on; the next reset merges them into a single block big enough for
+// all of it, so once a round has been laid out a reset is O(1) and allocates
+// nothing.
+typedef struct ArenaBlock {
+  struct ArenaBlock* next;  // the block filled before this one
+  size_t size;
+  size_t used;
+} ArenaBlock;
+
+typedef struct {
+  ArenaBlock* head;  // the block allocations come from, NULL before the first
+} Arena;
+
+// Reserves size bytes up front, 0 leaves it to the first allocation
+void arena_init(Arena* arena, size_t size);
+
+void arena_free(Arena* arena);
+
+// Forgets every allocation. Memory handed out before is reused.
+void arena_reset(Arena* arena);
+
+// Returns size bytes aligned for any type, exits through VALIDATE when the
+// heap is exhausted
+void* arena_alloc(Arena* arena, size_t size);
+
+// Same as arena_alloc with the memory zeroed
+void* arena_calloc(Arena* arena, size_t count, size_t size);
+
+// Returns the bytes handed out since the last reset
+size_t arena_used(const Arena* arena);
+
+// Frames or ticks at the start of a loop that may still allocate, e.g. the
+// first terminal output or read of a file. Past them a -DCOUNT_ALLOCS build
+// checks every one.
+#define ALLOC_WARMUP_FRAMES 8
+
+#ifdef COUNT_ALLOCS
+
+// Returns how many times the process called malloc, calloc, realloc,
+// aligned_alloc or posix_memalign. Built with -DCOUNT_ALLOCS the game wraps
+// them to count, so the game, headless and replay loops can check that they
+// never touch the heap. Allocations glibc makes internally bypass the
+// wrappers.
+uint64_t heap_allocations(void);
+
+// Aborts, through game_on_fatal like VALIDATE, when the heap was touched
+// since heap_allocations returned since; unit and n name the frame or tick
+void check_no_allocations(uint64_t since, const char* unit, long n);
+
+#else
+
+static inline uint64_t heap_allocations(void) { return 0; }
+
+static inline void check_no_allocations(uint64_t since, const char* unit,
+                                        long n) {
+  (void)since;
+  (void)unit;
+  (void)n;
+}
+
+#endif
+
+#endif
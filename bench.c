@@ -0,0 +1,731 @@
+#define _XOPEN_SOURCE 700
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "breakout.h"
+#include "broadcast.h"
+#include "collide.h"
+#include "effects.h"
+#include "game.h"
+#include "headless.h"
+#include "raster.h"
+#include "timing.h"
+#include "workers.h"
+
+// Roughly how many ball/brick pairs the brute-force pass may test per
+// configuration, keeps the slow cases from running for minutes
+#define PAIR_BUDGET 400000000LL
+
+typedef struct {
+  const char* name;
+  int (*run)(int argc, char** argv);
+} Benchmark;
+
+// The collision pass as it was before the broadphase: every ball against
+// every brick. Kept as the reference the grid has to agree with.
+static void resolve_naive(Brick* bricks, int* health, int total,
+                          BallPool* balls, DropPool* drops) {
+  for (int i = 0; i < balls->count; i++) {
+    Rect rect = ball_rect(balls, i);
+    int bounce = 0;
+    for (int index = 0; index < total; index++) {
+      if (health[index] > 0 && is_colliding(&bricks[index].rect, &rect)) {
+        int axes = ball_hit_axes(balls, i, &bricks[index].rect);
+        if (axes != 0) {
+          bounce |= axes;
+          if (--health[index] == 0) {
+            spawn_drop(drops, &bricks[index], &bricks[index].rect);
+          }
+        }
+      }
+    }
+    bounce_ball(balls, i, bounce);
+  }
+}
+
+// Moves the balls without losing any, so every rep sees the same ball count
+static void drift_balls(Game* game) {
+  BallPool* balls = &game->balls;
+  keep_balls_within_bounds(&game->win_conf, balls);
+  for (int i = 0; i < balls->count; i++) {
+    if (FIX_TO_CELL(balls->y[i]) >= game->win_conf.inner_rect.h &&
+        balls->vy[i] > 0) {
+      balls->vy[i] = -balls->vy[i];
+    }
+  }
+  move_balls(balls, 0, 1);
+}
+
+// Builds a board with the given brick grid and scattered balls, the window is
+// sized so every brick is three glyphs wide
+static void setup_board(Game* game, int cols, int rows, int balls,
+                        unsigned seed) {
+  int glyph = glyph_width(GLYPH_BRICK_STRONG);
+  WindowConfig win_conf;
+  init_win_conf(&win_conf, cols * (3 * glyph + BRICK_H_GAP) + 2,
+                rows * (BRICK_V_GAP + 1) + 12);
+
+  GameConfig config;
+  default_game_config(&config);
+  config.brick_cols = cols;
+  config.brick_rows = rows;
+  config.max_balls = balls + 1;
+  config.seed = seed;
+
+  init_game(game, &win_conf, &config);
+  scatter_balls(game, balls);
+}
+
+static int same_state(const Game* a, const Game* b) {
+  for (int i = 0; i < a->brick_total; i++) {
+    if (a->packed.health[i] != b->packed.health[i] ||
+        a->bricks[i].drop != b->bricks[i].drop) {
+      return 0;
+    }
+  }
+  if (a->drops.count != b->drops.count) {
+    return 0;
+  }
+  for (int i = 0; i < a->balls.count; i++) {
+    if (a->balls.vx[i] != b->balls.vx[i] ||
+        a->balls.vy[i] != b->balls.vy[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// Ball/brick collision, brute force against the uniform grid broadphase
+static int bench_collision(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  static const int boards[][2] = {{5, 5}, {40, 25}, {100, 100}};
+  static const int ball_counts[] = {1, 100, 1000, 4000};
+
+  printf("%8s %8s %6s %14s %14s %9s %6s\n", "bricks", "balls", "reps",
+         "naive ns/call", "grid ns/call", "speedup", "match");
+
+  for (size_t b = 0; b < sizeof(boards) / sizeof(boards[0]); b++) {
+    for (size_t n = 0; n < sizeof(ball_counts) / sizeof(ball_counts[0]); n++) {
+      int cols = boards[b][0];
+      int rows = boards[b][1];
+      int balls = ball_counts[n];
+
+      long long pairs = (long long)cols * rows * balls;
+      int reps = (int)(PAIR_BUDGET / pairs);
+      if (reps > 2000) {
+        reps = 2000;
+      }
+      if (reps < 3) {
+        reps = 3;
+      }
+
+      Game naive, grid;
+      setup_board(&naive, cols, rows, balls, 1234);
+      setup_board(&grid, cols, rows, balls, 1234);
+
+      uint64_t naive_ns = 0;
+      uint64_t grid_ns = 0;
+      for (int r = 0; r < reps; r++) {
+        uint64_t start = now_ns();
+        resolve_naive(naive.bricks, naive.packed.health, naive.brick_total,
+                      &naive.balls, &naive.drops);
+        naive_ns += now_ns() - start;
+
+        start = now_ns();
+        resolve_balls_brick_collision(grid.bricks, &grid.packed, &grid.grid,
+                                      &grid.balls, &grid.drops, &grid.events);
+        grid_ns += now_ns() - start;
+        clear_events(&grid.events);
+
+        drift_balls(&naive);
+        drift_balls(&grid);
+      }
+
+      printf("%8d %8d %6d %14.0f %14.0f %8.1fx %6s\n", naive.brick_total,
+             naive.balls.count, reps, (double)naive_ns / reps,
+             (double)grid_ns / reps, (double)naive_ns / (grid_ns ? grid_ns : 1),
+             same_state(&naive, &grid) ? "yes" : "NO");
+
+      free_game(&naive);
+      free_game(&grid);
+    }
+  }
+
+  return 0;
+}
+
+// Random rect near the board, sized like a ball or a drop, often landing
+// exactly on a brick edge
+static Rect random_probe(const Game* game) {
+  const Rect* outer = &game->win_conf.rect;
+  return (Rect){rand() % (outer->w + 4) - 2, rand() % (outer->h + 4) - 2,
+                1 + rand() % 2, 1};
+}
+
+// Checks every kernel against is_colliding, then times one rect against a
+// whole board with each of them
+static int bench_simd(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  Game game;
+  setup_board(&game, 100, 100, 0, 99);
+  const PackedBricks* packed = &game.packed;
+  int total = packed->count;
+
+  // Break every fifth brick, the kernels must not report it
+  for (int i = 0; i < total; i += 5) {
+    game.packed.health[i] = 0;
+  }
+  int words = (total + 31) / 32;
+
+  uint32_t* expected = calloc(words, sizeof(uint32_t));
+  uint32_t* mask = calloc(words, sizeof(uint32_t));
+  int* index = malloc(sizeof(int) * total);
+  VALIDATE(expected);
+  VALIDATE(mask);
+  VALIDATE(index);
+
+  // Check correctness over many probes for every available kernel
+  for (int k = KERNEL_SCALAR; k < KERNEL_COUNT; k++) {
+    if (!collide_select_kernel(k)) {
+      printf("%-8s not supported on this CPU\n", collide_kernel_name(k));
+      continue;
+    }
+
+    srand(7);
+    for (int probe = 0; probe < 2000; probe++) {
+      Rect rect = random_probe(&game);
+      memset(expected, 0, sizeof(uint32_t) * words);
+      for (int i = 0; i < total; i++) {
+        if (packed->health[i] > 0 &&
+            is_colliding(&game.bricks[i].rect, &rect)) {
+          expected[i / 32] |= 1u << (i % 32);
+        }
+      }
+
+      // Offset the range start so the vector loops see unaligned heads
+      int first = probe % 7;
+      bricks_hit_mask(packed, first, total - first, &rect, mask);
+      for (int i = first; i < total; i++) {
+        int got = (mask[(i - first) / 32] >> ((i - first) % 32)) & 1;
+        if (got != (int)((expected[i / 32] >> (i % 32)) & 1)) {
+          printf("%-8s range mismatch at brick %d\n", collide_kernel_name(k),
+                 i);
+          return 1;
+        }
+      }
+
+      // Indexed batches of up to 32 shuffled bricks
+      int batch = 1 + probe % 32;
+      for (int j = 0; j < batch; j++) {
+        index[j] = rand() % total;
+      }
+      uint32_t hits = bricks_hit_mask_indexed(packed, index, batch, &rect);
+      for (int j = 0; j < batch; j++) {
+        int want = (expected[index[j] / 32] >> (index[j] % 32)) & 1;
+        if ((int)((hits >> j) & 1) != want) {
+          printf("%-8s indexed mismatch at slot %d\n", collide_kernel_name(k),
+                 j);
+          return 1;
+        }
+      }
+    }
+  }
+
+  printf("%d bricks per call, masks match is_colliding on the unbroken ones "
+         "for every kernel\n",
+         total);
+  printf("%-16s %12s %10s\n", "kernel", "ns/call", "ns/brick");
+
+  enum { REPS = 2000 };
+  srand(11);
+  Rect probes[64];
+  for (int i = 0; i < 64; i++) {
+    probes[i] = random_probe(&game);
+  }
+
+  // The Brick structs with is_colliding, the way the game tested pairs before
+  volatile uint32_t sink = 0;
+  uint64_t start = now_ns();
+  for (int r = 0; r < REPS; r++) {
+    const Rect* rect = &probes[r % 64];
+    uint32_t count = 0;
+    for (int i = 0; i < total; i++) {
+      count += is_colliding(&game.bricks[i].rect, rect);
+    }
+    sink += count;
+  }
+  uint64_t elapsed = now_ns() - start;
+  printf("%-16s %12.0f %10.3f\n", "is_colliding", (double)elapsed / REPS,
+         (double)elapsed / REPS / total);
+
+  for (int k = KERNEL_SCALAR; k < KERNEL_COUNT; k++) {
+    if (!collide_select_kernel(k)) {
+      continue;
+    }
+
+    start = now_ns();
+    for (int r = 0; r < REPS; r++) {
+      bricks_hit_mask(packed, 0, total, &probes[r % 64], mask);
+      sink += mask[0];
+    }
+    elapsed = now_ns() - start;
+    printf("%-16s %12.0f %10.3f\n", collide_kernel_name(k),
+           (double)elapsed / REPS, (double)elapsed / REPS / total);
+  }
+  (void)sink;
+
+  collide_select_kernel(KERNEL_AUTO);
+  printf("runtime dispatch picks %s\n",
+         collide_kernel_name(collide_active_kernel()));
+
+  free(expected);
+  free(mask);
+  free(index);
+  free_game(&game);
+  return 0;
+}
+
+// Batched environment steps with a random policy, the way a trainer drives
+// the library
+static int bench_env(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  static const int counts[] = {1, 64, 1024, 4096};
+
+  EnvConfig config;
+  env_default_config(&config);
+  config.max_steps = 2000;
+  config.glyphs = glyphs_active()->set;
+
+  printf("%8s %8s %14s %14s %10s\n", "envs", "steps", "ns/batch", "ns/env-step",
+         "episodes");
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    int count = counts[c];
+    int steps = 4000000 / count;
+
+    BreakoutEnv* env = env_create(count, &config);
+    if (env == NULL) {
+      return 1;
+    }
+    int obs_size = env_obs_size(env);
+    uint8_t* actions = malloc(count);
+    float* rewards = malloc(sizeof(float) * count);
+    uint8_t* dones = malloc(count);
+    float* obs = malloc(sizeof(float) * count * obs_size);
+    VALIDATE(actions);
+    VALIDATE(rewards);
+    VALIDATE(dones);
+    VALIDATE(obs);
+
+    env_reset(env, 1, obs);
+    srand(3);
+    long episodes = 0;
+    uint64_t elapsed = 0;
+    for (int s = 0; s < steps; s++) {
+      for (int i = 0; i < count; i++) {
+        actions[i] = rand() % ENV_ACTION_COUNT;
+      }
+
+      uint64_t start = now_ns();
+      env_step_batch(env, actions, rewards, dones, obs);
+      elapsed += now_ns() - start;
+
+      for (int i = 0; i < count; i++) {
+        episodes += dones[i];
+      }
+    }
+
+    printf("%8d %8d %14.0f %14.1f %10ld\n", count, steps,
+           (double)elapsed / steps, (double)elapsed / steps / count, episodes);
+
+    free(actions);
+    free(rewards);
+    free(dones);
+    free(obs);
+    env_destroy(env);
+  }
+
+  return 0;
+}
+
+// Breaks bricks all over a window at a steady rate and runs the effect
+// pool's frames on them, with and without a budget tight enough to bite
+static int bench_effects(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  enum { FRAMES = 2400, FPS = 24, PARTICLES = 4096 };
+  static const int rates[] = {100, 1000, 10000};  // bricks broken per second
+  static const uint64_t budgets[] = {UINT64_MAX, 2000};
+
+  printf("%10s %10s %12s %12s %8s %10s %10s\n", "bricks/s", "budget ns",
+         "asked/s", "spawned/s", "live", "p50 ns", "p99 ns");
+
+  Arena arena;
+  arena_init(&arena, 0);
+  LatencyHist hist;
+  Rect bounds = {1, 1, 98, 28};
+
+  // Where the bricks break, picked up front so the timing is the pool's
+  static Rect bricks[1024];
+  srand(5);
+  for (int i = 0; i < 1024; i++) {
+    bricks[i] = (Rect){1 + rand() % 90, 1 + rand() % 20, 8, 1};
+  }
+
+  for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+    for (size_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); b++) {
+      EffectsConfig config = {PARTICLES, budgets[b]};
+      EffectPool pool;
+      arena_reset(&arena);
+      effects_init(&pool, &config, &bounds, &arena);
+      hist_reset(&hist);
+
+      long live = 0;
+      long broken = 0;
+      for (int f = 0; f < FRAMES; f++) {
+        uint64_t start = now_ns();
+        // Spread the rate over the frames so every second breaks exactly it
+        long due = (long)rates[r] * (f + 1) / FPS;
+        for (; broken < due; broken++) {
+          effects_brick_broken(&pool, &bricks[broken % 1024],
+                               SCORE_BRICK_DESTROYED);
+        }
+        effects_update(&pool);
+        uint64_t spent = now_ns() - start;
+        effects_account(&pool, spent);
+        hist_record(&hist, spent);
+        live += pool.count;
+      }
+
+      double seconds = (double)FRAMES / FPS;
+      char budget[24];
+      if (budgets[b] == UINT64_MAX) {
+        snprintf(budget, sizeof(budget), "none");
+      } else {
+        snprintf(budget, sizeof(budget), "%llu",
+                 (unsigned long long)budgets[b]);
+      }
+      printf("%10d %10s %12.0f %12.0f %8ld %10llu %10llu\n", rates[r], budget,
+             (pool.spawned + pool.skipped) / seconds, pool.spawned / seconds,
+             live / FRAMES,
+             (unsigned long long)hist_percentile(&hist, 0.50),
+             (unsigned long long)hist_percentile(&hist, 0.99));
+    }
+  }
+
+  arena_free(&arena);
+  return 0;
+}
+
+// Checks that every downsampled raster keeps the highest code of its blocks
+// at full size, then times raster_game on the default window and on large
+// boards
+static int bench_raster(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  static const int boards[][3] = {{5, 5, 1}, {40, 25, 100}, {100, 100, 1000}};
+  static const int shifts[] = {0, 1, 2};
+
+  printf("%8s %8s %10s %6s %10s %10s\n", "bricks", "balls", "window", "shift",
+         "cells", "ns/call");
+
+  for (size_t b = 0; b < sizeof(boards) / sizeof(boards[0]); b++) {
+    Game game;
+    if (b == 0) {
+      // The window headless runs and the library play in by default
+      EnvConfig env;
+      env_default_config(&env);
+      WindowConfig win_conf;
+      init_win_conf(&win_conf, env.width, env.height);
+      GameConfig config;
+      default_game_config(&config);
+      init_game(&game, &win_conf, &config);
+    } else {
+      setup_board(&game, boards[b][0], boards[b][1], boards[b][2], 21);
+    }
+
+    int cols = raster_cols(&game, 0);
+    int rows = raster_rows(&game, 0);
+    uint8_t* full = malloc((size_t)cols * rows);
+    uint8_t* cells = malloc((size_t)cols * rows);
+    VALIDATE(full);
+    VALIDATE(cells);
+    raster_game(&game, full, 0, 0);
+
+    for (size_t s = 0; s < sizeof(shifts) / sizeof(shifts[0]); s++) {
+      int shift = shifts[s];
+      int scaled_cols = raster_cols(&game, shift);
+      raster_game(&game, cells, shift, shift);
+      for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+          uint8_t block = cells[(y >> shift) * scaled_cols + (x >> shift)];
+          if (full[y * cols + x] > block) {
+            printf("shift %d hides cell %d,%d\n", shift, x, y);
+            return 1;
+          }
+        }
+      }
+
+      enum { REPS = 20000 };
+      uint64_t start = now_ns();
+      for (int r = 0; r < REPS; r++) {
+        raster_game(&game, cells, shift, shift);
+      }
+      uint64_t elapsed = now_ns() - start;
+
+      char window[24];
+      snprintf(window, sizeof(window), "%dx%d", cols, rows);
+      printf("%8d %8d %10s %6d %10d %10.1f\n", game.brick_total,
+             game.balls.count, window, shift,
+             scaled_cols * raster_rows(&game, shift), (double)elapsed / REPS);
+    }
+
+    free(full);
+    free(cells);
+    free_game(&game);
+  }
+
+  return 0;
+}
+
+// Steps a board with the ball passes shared among threads next to the serial
+// step, checking the state hashes agree after every tick
+static int bench_threads(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  static const int boards[][3] = {{40, 25, 100}, {100, 100, 1000}};
+  static const int threads[] = {1, 2, 4};
+  enum { TICKS = 300 };
+
+  printf("%8s %8s %8s %12s %12s %8s\n", "bricks", "balls", "threads",
+         "serial ns", "threaded ns", "speedup");
+
+  for (size_t b = 0; b < sizeof(boards) / sizeof(boards[0]); b++) {
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+      Game serial;
+      Game threaded;
+      setup_board(&serial, boards[b][0], boards[b][1], boards[b][2], 23);
+      setup_board(&threaded, boards[b][0], boards[b][1], boards[b][2], 23);
+
+      StepWorkers workers;
+      if (!step_workers_start(&workers, &threaded, threads[t])) {
+        return 1;
+      }
+
+      GameInput input = {.paddle_dir = 0, .launch = 1};
+      uint64_t serial_ns = 0;
+      uint64_t threaded_ns = 0;
+      for (int tick = 0; tick < TICKS; tick++) {
+        uint64_t start = now_ns();
+        game_step(&serial, &input);
+        uint64_t middle = now_ns();
+        game_step(&threaded, &input);
+        threaded_ns += now_ns() - middle;
+        serial_ns += middle - start;
+        clear_events(&serial.events);
+        clear_events(&threaded.events);
+
+        if (game_state_hash(&serial) != game_state_hash(&threaded)) {
+          printf("%d threads differ from the serial step at tick %d\n",
+                 threads[t], tick);
+          return 1;
+        }
+      }
+
+      printf("%8d %8d %8d %12.0f %12.0f %7.2fx\n", serial.brick_total,
+             boards[b][2], threads[t], (double)serial_ns / TICKS,
+             (double)threaded_ns / TICKS,
+             threaded_ns ? (double)serial_ns / threaded_ns : 0.0);
+
+      step_workers_stop(&workers);
+      free_game(&serial);
+      free_game(&threaded);
+    }
+  }
+
+  return 0;
+}
+
+// Returns 1 when what a spectator put together matches the game
+static int same_view(const GameSnapshot* view, const Game* game) {
+  if (view->paddle.rect.x != game->paddle.rect.x ||
+      view->balls.count != game->balls.count ||
+      view->drops.count != game->drops.count ||
+      view->scroll.shift != game->packed.scroll.shift ||
+      view->score != game->score) {
+    return 0;
+  }
+  for (int i = 0; i < game->balls.count; i++) {
+    Rect a = ball_rect(&view->balls, i);
+    Rect b = ball_rect(&game->balls, i);
+    if (a.x != b.x || a.y != b.y) {
+      return 0;
+    }
+  }
+  for (int i = 0; i < game->drops.count; i++) {
+    const Drop* a = &view->drops.items[i];
+    const Drop* b = &game->drops.items[i];
+    if (a->rect.x != b->rect.x || a->rect.y != b->rect.y ||
+        a->type != b->type || a->glyph != b->glyph) {
+      return 0;
+    }
+  }
+  for (int i = 0; i < game->brick_total; i++) {
+    int health = game->packed.health[i] > 0 ? game->packed.health[i] : 0;
+    if (view->health[i] != health ||
+        brick_bit(&view->alive, i) != brick_bit(&game->packed.alive, i)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// Publishes a game frame by frame, checking that a spectator reading every
+// frame and one that only reads now and then both see the game as it is,
+// and times the publishing
+static int bench_broadcast(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  static const int boards[][3] = {{0, 0, 0}, {40, 25, 100}, {100, 100, 1000}};
+  enum { FRAMES = 3000, SLOW_EVERY = 97 };
+
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/benchmark-broadcast-%d", (int)getpid());
+
+  printf("%8s %8s %12s %12s %12s\n", "bricks", "balls", "ns/publish",
+         "bytes/frame", "slow skipped");
+
+  for (size_t b = 0; b < sizeof(boards) / sizeof(boards[0]); b++) {
+    Game game;
+    GameConfig config;
+    default_game_config(&config);
+    if (b == 0) {
+      // The window a terminal game gets by default
+      EnvConfig env;
+      env_default_config(&env);
+      WindowConfig win_conf;
+      init_win_conf(&win_conf, env.width, env.height);
+      init_game(&game, &win_conf, &config);
+    } else {
+      setup_board(&game, boards[b][0], boards[b][1], boards[b][2], 29);
+    }
+
+    ReplayHeader layout;
+    replay_header_init(&layout, &game.win_conf, &config);
+    Broadcast cast;
+    if (!broadcast_open(&cast, path, &game, &layout)) {
+      return 1;
+    }
+
+    Spectator fast;
+    Spectator slow;
+    GameSnapshot fast_view;
+    GameSnapshot slow_view;
+    if (!spectator_open(&fast, path) || !spectator_open(&slow, path)) {
+      return 1;
+    }
+    snapshot_init(&fast_view, &game);
+    snapshot_init(&slow_view, &game);
+    snapshot_capture(&fast_view, &game);
+    snapshot_capture(&slow_view, &game);
+
+    GameInput input = {.paddle_dir = 0, .launch = 1};
+    uint64_t publish_ns = 0;
+    for (int frame = 0; frame < FRAMES; frame++) {
+      game_step(&game, &input);
+      clear_events(&game.events);
+      if (game.game_over) {
+        config.seed++;
+        reset_game(&game, &config);
+      }
+
+      uint64_t start = now_ns();
+      broadcast_publish(&cast, &game, 0);
+      publish_ns += now_ns() - start;
+
+      spectator_read(&fast, &fast_view);
+      if (!same_view(&fast_view, &game)) {
+        printf("the spectator differs from the game at frame %d\n", frame);
+        return 1;
+      }
+      if (frame % SLOW_EVERY == SLOW_EVERY - 1) {
+        spectator_read(&slow, &slow_view);
+        if (!same_view(&slow_view, &game)) {
+          printf("the late spectator differs from the game at frame %d\n",
+                 frame);
+          return 1;
+        }
+      }
+    }
+
+    printf("%8d %8d %12.1f %12.0f %12llu\n", game.brick_total,
+           boards[b][2] + 1, (double)publish_ns / FRAMES,
+           (double)cast.bytes / FRAMES, (unsigned long long)slow.skipped);
+
+    snapshot_free(&fast_view);
+    snapshot_free(&slow_view);
+    spectator_close(&fast);
+    spectator_close(&slow);
+    broadcast_close(&cast);
+    free_game(&game);
+  }
+
+  return 0;
+}
+
+static const Benchmark benchmarks[] = {
+    {"collision", bench_collision},
+    {"simd", bench_simd},
+    {"env", bench_env},
+    {"effects", bench_effects},
+    {"raster", bench_raster},
+    {"threads", bench_threads},
+    {"broadcast", bench_broadcast},
+};
+
+int main(int argc, char** argv) {
+  setlocale(LC_ALL, "");
+  if (!glyph_widths_known()) {
+    return EXIT_FAILURE;
+  }
+
+  int count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+  int ran = 0;
+
+  for (int i = 0; i < count; i++) {
+    if (argc > 1 && strcmp(argv[1], benchmarks[i].name) != 0) {
+      continue;
+    }
+
+    printf("── %s ──\n", benchmarks[i].name);
+    if (benchmarks[i].run(argc - 1, argv + 1) != 0) {
+      return EXIT_FAILURE;
+    }
+    ran++;
+  }
+
+  if (ran == 0) {
+    fprintf(stderr, "Usage: %s [benchmark]\nBenchmarks:", argv[0]);
+    for (int i = 0; i < count; i++) {
+      fprintf(stderr, " %s", benchmarks[i].name);
+    }
+    fprintf(stderr, "\n");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+#define _XOPEN_SOURCE 700
+
+#include "breakout.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void env_default_config(EnvConfig* config) {
+  config->width = 80;
+  config->height = 24;
+  default_game_config(&config->game);
+  config->game.max_balls = ENV_MAX_BALLS;
+  config->game.max_events = ENV_MAX_EVENTS;
+  config->max_steps = 0;
+  config->glyphs = GLYPH_SET_ASCII;
+}
+
+BreakoutEnv* env_create(int count, const EnvConfig* config) {
+  // The paddle, the balls and the bricks are measured in glyph widths
+  glyphs_select(config->glyphs);
+  WindowConfig win_conf;
+  init_win_conf(&win_conf, config->width, config->height);
+  if (!glyph_widths_known() || !board_fits(&win_conf, &config->game)) {
+    return NULL;
+  }
+
+  BreakoutEnv* env = calloc(1, sizeof(BreakoutEnv));
+  VALIDATE(env);
+
+  env->count = count;
+  env->config = *config;
+  env->win_conf = win_conf;
+
+  env->games = calloc(count + 1, sizeof(Game));
+  VALIDATE(env->games);
+  env->steps = calloc(count + 1, sizeof(long));
+  VALIDATE(env->steps);
+
+  for (int i = 0; i < count; i++) {
+    init_game(&env->games[i], &env->win_conf, &env->config.game);
+  }
+
+  int bricks = count > 0 ? env->games[0].brick_total : 0;
+  env->obs_size = ENV_OBS_HEADER + bricks;
+  return env;
+}
+
+void env_destroy(BreakoutEnv* env) {
+  for (int i = 0; i < env->count; i++) {
+    free_game(&env->games[i]);
+  }
+  free(env->games);
+  free(env->steps);
+  free(env);
+}
+
+// Starts game i over with the given seed
+static void reset_one(BreakoutEnv* env, int i, uint64_t seed) {
+  env->config.game.seed = seed;
+  reset_game(&env->games[i], &env->config.game);
+  env->steps[i] = 0;
+}
+
+void env_reset(BreakoutEnv* env, uint64_t seed, float* obs) {
+  for (int i = 0; i < env->count; i++) {
+    reset_one(env, i, seed + i);
+  }
+  env->next_seed = seed + env->count;
+
+  if (obs) {
+    env_observe(env, obs);
+  }
+}
+
+void env_step_batch(BreakoutEnv* env, const uint8_t* actions, float* rewards,
+                    uint8_t* dones, float* obs) {
+  for (int i = 0; i < env->count; i++) {
+    Game* game = &env->games[i];
+
+    GameInput input = {0};
+    switch (actions[i]) {
+      case ENV_ACTION_LEFT:
+        input.paddle_dir = -1;
+        break;
+      case ENV_ACTION_RIGHT:
+        input.paddle_dir = 1;
+        break;
+      case ENV_ACTION_LAUNCH:
+        input.launch = 1;
+        break;
+      default:
+        break;
+    }
+
+    long score = game->score;
+    game_step(game, &input);
+    clear_events(&game->events);
+    env->steps[i]++;
+
+    rewards[i] = (float)(game->score - score);
+    dones[i] = game->game_over || (env->config.max_steps > 0 &&
+                                   env->steps[i] >= env->config.max_steps);
+    if (dones[i]) {
+      reset_one(env, i, env->next_seed++);
+    }
+  }
+
+  if (obs) {
+    env_observe(env, obs);
+  }
+}
+
+void env_observe(const BreakoutEnv* env, float* obs) {
+  float w = (float)FIX_FROM_CELL(env->win_conf.rect.w);
+  float h = (float)FIX_FROM_CELL(env->win_conf.rect.h);
+
+  for (int i = 0; i < env->count; i++) {
+    const Game* game = &env->games[i];
+    float* out = obs + (size_t)i * env->obs_size;
+
+    const BallPool* balls = &game->balls;
+    float speed = balls->speed > 0 ? (float)balls->speed : 1.0f;
+    out[0] = FIX_FROM_CELL(game->paddle.rect.x) / w;
+    out[1] = FIX_FROM_CELL(game->paddle.rect.w) / w;
+
+    for (int b = 0; b < ENV_OBS_BALLS; b++) {
+      float* ball = out + 2 + 4 * b;
+      if (b < balls->count) {
+        ball[0] = balls->x[b] / w;
+        ball[1] = balls->y[b] / h;
+        ball[2] = balls->vx[b] / speed;
+        ball[3] = balls->vy[b] / speed;
+      } else {
+        ball[0] = ball[1] = ball[2] = ball[3] = 0.0f;
+      }
+    }
+
+    const int* health = game->packed.health;
+    float* bricks = out + ENV_OBS_HEADER;
+    for (int b = 0; b < game->brick_total; b++) {
+      bricks[b] = health[b] * (1.0f / LEVEL_MAX_HEALTH);
+    }
+  }
+}
+
+int env_obs_size(const BreakoutEnv* env) { return env->obs_size; }
+
+const Game* env_game(const BreakoutEnv* env, int i) { return &env->games[i]; }
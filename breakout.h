@@ -0,0 +1,92 @@
+#ifndef BREAKOUT_H
+#define BREAKOUT_H
+
+// libbreakout: the simulation as an embeddable library for driving many
+// games at once, e.g. as a training environment for paddle controllers.
+//
+// A BreakoutEnv holds count independent games that are allocated together
+// when it is created. Stepping, resetting and observing only write into the
+// caller's buffers, nothing is allocated after env_create.
+
+#include <stdint.h>
+
+#include "game.h"
+
+// Actions, one per game and step. The paddle only moves on the steps that
+// choose left or right.
+typedef enum {
+  ENV_ACTION_NONE,
+  ENV_ACTION_LEFT,
+  ENV_ACTION_RIGHT,
+  ENV_ACTION_LAUNCH,
+  ENV_ACTION_COUNT
+} EnvAction;
+
+// Balls described in an observation, the rest are left out
+#define ENV_OBS_BALLS 4
+
+// Defaults that keep a game small, so thousands of them stay in cache. The
+// events are consumed after every step, which only needs a short queue.
+#define ENV_MAX_BALLS 16
+#define ENV_MAX_EVENTS 256
+
+// Observation of one game, as floats scaled to about [0, 1]:
+//   paddle x, paddle width
+//   x, y, vx, vy of the first ENV_OBS_BALLS balls, the velocity as a share
+//   of the ball speed, zeros when missing
+//   health / LEVEL_MAX_HEALTH of every brick
+#define ENV_OBS_HEADER (2 + 4 * ENV_OBS_BALLS)
+
+typedef struct {
+  int width;
+  int height;
+  GameConfig game;  // brick_cols, brick_rows, max_balls and an optional level
+  long max_steps;   // an episode ends after this many steps, 0 for no limit
+  GlyphSet glyphs;  // measures the board, ascii is one cell wide anywhere
+} EnvConfig;
+
+typedef struct {
+  int count;
+  EnvConfig config;
+  WindowConfig win_conf;
+
+  Game* games;  // count games, side by side
+  long* steps;  // steps taken in each game's current episode
+  uint64_t next_seed;
+
+  int obs_size;
+} BreakoutEnv;
+
+// Fills in the default board and an 80x24 window laid out in ascii glyphs,
+// which does not depend on the caller's locale
+void env_default_config(EnvConfig* config);
+
+// Allocates count games, call env_reset before stepping them. Makes
+// config->glyphs the active set; returns NULL and prints why when the
+// locale does not know the widths of its glyphs or the board does not fit
+// the window.
+BreakoutEnv* env_create(int count, const EnvConfig* config);
+
+void env_destroy(BreakoutEnv* env);
+
+// Starts a new episode in every game, game i is seeded with seed + i. Writes
+// the first observations when obs is not NULL.
+void env_reset(BreakoutEnv* env, uint64_t seed, float* obs);
+
+// Advances every game by one tick with actions[i]. Writes the points each
+// game scored into rewards and whether its episode ended into dones. A game
+// that is done starts its next episode right away, with the next unused
+// seed, and obs (when not NULL) holds the first observation of that episode.
+void env_step_batch(BreakoutEnv* env, const uint8_t* actions, float* rewards,
+                    uint8_t* dones, float* obs);
+
+// Writes the observation of every game, env_obs_size floats per game
+void env_observe(const BreakoutEnv* env, float* obs);
+
+// Returns the number of floats in one game's observation
+int env_obs_size(const BreakoutEnv* env);
+
+// Returns game i, e.g. to draw it
+const Game* env_game(const BreakoutEnv* env, int i);
+
+#endif
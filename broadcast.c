@@ -0,0 +1,419 @@
+#define _XOPEN_SOURCE 700
+
+#include "broadcast.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The slots start a cache line after the header
+#define SLOTS_OFFSET ((sizeof(BroadcastHeader) + 63) & ~(size_t)63)
+
+static BroadcastSlot* slot_at(uint8_t* map, uint32_t slot_size, uint64_t n) {
+  return (BroadcastSlot*)(map + SLOTS_OFFSET +
+                          (size_t)slot_size * (n % BROADCAST_SLOTS));
+}
+
+// Bricks compared at once while looking for the changed ones
+#define DIFF_BLOCK 64
+
+// Health as a frame carries it
+static uint8_t health_byte(int health) {
+  return health <= 0 ? 0 : health > 255 ? 255 : health;
+}
+
+// Removes what an earlier broadcast left at path, anything else that is
+// there is not ours to delete. Returns 0 and prints why when path holds
+// something that is not a broadcast.
+static int remove_old_broadcast(const char* path) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return 1;
+    }
+    fprintf(stderr, "Error: cannot open %s: %s\n", path, strerror(errno));
+    return 0;
+  }
+
+  char magic[sizeof(((BroadcastHeader*)0)->magic)];
+  struct stat st;
+  int old = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+            read(fd, magic, sizeof(magic)) == (ssize_t)sizeof(magic) &&
+            memcmp(magic, BROADCAST_MAGIC, sizeof(magic)) == 0;
+  close(fd);
+  if (!old) {
+    fprintf(stderr,
+            "Error: %s exists and is not a broadcast, it is left alone\n",
+            path);
+    return 0;
+  }
+  if (unlink(path) != 0) {
+    fprintf(stderr, "Error: cannot remove %s: %s\n", path, strerror(errno));
+    return 0;
+  }
+  return 1;
+}
+
+int broadcast_open(Broadcast* cast, const char* path, const Game* game,
+                   const ReplayHeader* layout) {
+  // A delta is only sent while it is smaller than a keyframe, but looking
+  // for the changed bricks may list up to all of them before giving up
+  int total = game->brick_total;
+  size_t frame_max = sizeof(BroadcastFrame) + 4 * (size_t)game->balls.capacity +
+                     5 * (size_t)game->drops.capacity + 4 * (size_t)total;
+  size_t slot_size = (sizeof(BroadcastSlot) + frame_max + 7) & ~(size_t)7;
+  size_t size = SLOTS_OFFSET + slot_size * BROADCAST_SLOTS;
+
+  // A new file, spectators still mapping an old one keep it as it was
+  if (!remove_old_broadcast(path)) {
+    return 0;
+  }
+  int fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "Error: cannot create %s: %s\n", path, strerror(errno));
+    return 0;
+  }
+  if (ftruncate(fd, size) != 0) {
+    fprintf(stderr, "Error: cannot size %s: %s\n", path, strerror(errno));
+    close(fd);
+    unlink(path);
+    return 0;
+  }
+  uint8_t* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "Error: cannot map %s: %s\n", path, strerror(errno));
+    unlink(path);
+    return 0;
+  }
+
+  cast->path = path;
+  cast->map = map;
+  cast->size = size;
+  cast->header = (BroadcastHeader*)map;
+  cast->health = malloc(sizeof(int) * (total + 1));
+  VALIDATE(cast->health);
+  cast->shift = 0;
+  cast->total = total;
+  cast->frame = 0;
+  cast->keyframe = 0;
+  cast->bytes = 0;
+
+  BroadcastHeader* header = cast->header;
+  header->version = BROADCAST_VERSION;
+  header->slot_size = slot_size;
+  header->slot_count = BROADCAST_SLOTS;
+  header->layout = *layout;
+  atomic_init(&header->frames, 0);
+  atomic_init(&header->keyframe, 0);
+  atomic_init(&header->live, 1);
+  atomic_thread_fence(memory_order_release);
+  memcpy(header->magic, BROADCAST_MAGIC, sizeof(header->magic));
+  return 1;
+}
+
+void broadcast_publish(Broadcast* cast, const Game* game, int paused) {
+  BroadcastHeader* header = cast->header;
+  uint64_t n = cast->frame;
+  BroadcastSlot* slot = slot_at(cast->map, header->slot_size, n);
+  atomic_store_explicit(&slot->seq, 2 * n + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  BroadcastFrame* frame = (BroadcastFrame*)(slot + 1);
+  uint8_t* bytes = (uint8_t*)(frame + 1);
+  const int* health = game->packed.health;
+  int total = cast->total;
+
+  // The changed bricks go straight into the slot, a delta that grows past
+  // the size of a keyframe is given up for one. Most frames change a brick
+  // or two, so the bricks are compared a block at a time first.
+  int keyframe = n == 0 || n - cast->keyframe >= BROADCAST_KEYFRAME_INTERVAL ||
+                 game->packed.scroll.shift != cast->shift;
+  uint32_t* changed = (uint32_t*)bytes;
+  int count = 0;
+  for (int base = 0; base < total && !keyframe; base += DIFF_BLOCK) {
+    int end = base + DIFF_BLOCK < total ? base + DIFF_BLOCK : total;
+    if (memcmp(health + base, cast->health + base,
+               sizeof(int) * (end - base)) == 0) {
+      continue;
+    }
+    for (int i = base; i < end; i++) {
+      if (health[i] != cast->health[i]) {
+        changed[count++] = i;
+      }
+    }
+    keyframe = 5 * count > total;
+  }
+  if (!keyframe) {
+    bytes += 4 * (size_t)count;
+  }
+
+  const BallPool* balls = &game->balls;
+  int16_t* cells = (int16_t*)bytes;
+  for (int i = 0; i < balls->count; i++) {
+    cells[2 * i] = FIX_TO_CELL(balls->x[i]);
+    cells[2 * i + 1] = FIX_TO_CELL(balls->y[i]);
+  }
+  bytes += 4 * (size_t)balls->count;
+
+  const DropPool* drops = &game->drops;
+  cells = (int16_t*)bytes;
+  uint8_t* types = bytes + 4 * (size_t)drops->count;
+  for (int i = 0; i < drops->count; i++) {
+    cells[2 * i] = drops->items[i].rect.x;
+    cells[2 * i + 1] = drops->items[i].rect.y;
+    types[i] = drops->items[i].type;
+  }
+  bytes = types + drops->count;
+
+  if (keyframe) {
+    for (int i = 0; i < total; i++) {
+      bytes[i] = health_byte(health[i]);
+    }
+    memcpy(cast->health, health, sizeof(int) * total);
+    bytes += total;
+    count = total;
+  } else {
+    for (int k = 0; k < count; k++) {
+      cast->health[changed[k]] = health[changed[k]];
+      bytes[k] = health_byte(health[changed[k]]);
+    }
+    bytes += count;
+  }
+
+  *frame = (BroadcastFrame){
+      .flags = (keyframe ? BROADCAST_KEYFRAME : 0) |
+               (paused ? BROADCAST_PAUSED : 0),
+      .shift = game->packed.scroll.shift,
+      .score = game->score,
+      .paddle_x = game->paddle.rect.x,
+      .paddle_w = game->paddle.rect.w,
+      .balls = balls->count,
+      .drops = drops->count,
+      .bricks = count,
+  };
+  slot->size = bytes - (uint8_t*)frame;
+  cast->bytes += slot->size;
+
+  // The slot is complete before the counters point anyone at it
+  atomic_store_explicit(&slot->seq, 2 * n + 2, memory_order_release);
+  atomic_store_explicit(&header->frames, n + 1, memory_order_release);
+  if (keyframe) {
+    atomic_store_explicit(&header->keyframe, n, memory_order_release);
+    cast->keyframe = n;
+  }
+  cast->shift = game->packed.scroll.shift;
+  cast->frame++;
+}
+
+void broadcast_close(Broadcast* cast) {
+  atomic_store_explicit(&cast->header->live, 0, memory_order_release);
+  munmap(cast->map, cast->size);
+  unlink(cast->path);
+  free(cast->health);
+  cast->map = NULL;
+  cast->header = NULL;
+  cast->health = NULL;
+}
+
+int spectator_open(Spectator* spec, const char* path) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf(stderr, "Error: cannot open %s: %s\n", path, strerror(errno));
+    return 0;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < SLOTS_OFFSET) {
+    fprintf(stderr, "Error: %s is not a broadcast\n", path);
+    close(fd);
+    return 0;
+  }
+  size_t size = st.st_size;
+  const uint8_t* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "Error: cannot map %s: %s\n", path, strerror(errno));
+    return 0;
+  }
+
+  const BroadcastHeader* header = (const BroadcastHeader*)map;
+  int valid =
+      memcmp(header->magic, BROADCAST_MAGIC, sizeof(header->magic)) == 0;
+  atomic_thread_fence(memory_order_acquire);
+  if (!valid || header->version != BROADCAST_VERSION ||
+      header->slot_count != BROADCAST_SLOTS ||
+      header->slot_size < sizeof(BroadcastSlot) + sizeof(BroadcastFrame) ||
+      size < SLOTS_OFFSET + (size_t)header->slot_size * BROADCAST_SLOTS) {
+    fprintf(stderr, "Error: %s is not a broadcast this version can show\n",
+            path);
+    munmap((void*)map, size);
+    return 0;
+  }
+
+  spec->map = map;
+  spec->size = size;
+  spec->header = header;
+  spec->frame = malloc(header->slot_size);
+  VALIDATE(spec->frame);
+  spec->next = 0;
+  spec->synced = 0;
+  spec->skipped = 0;
+  return 1;
+}
+
+void spectator_close(Spectator* spec) {
+  munmap((void*)spec->map, spec->size);
+  free(spec->frame);
+  spec->map = NULL;
+  spec->header = NULL;
+  spec->frame = NULL;
+}
+
+int spectator_live(const Spectator* spec) {
+  return atomic_load_explicit(&spec->header->live, memory_order_acquire);
+}
+
+// Copies frame n out of its slot. Returns 1 when it was there and stayed
+// intact while it was copied, -1 when it was overwritten.
+static int copy_frame(Spectator* spec, uint64_t n) {
+  uint32_t slot_size = spec->header->slot_size;
+  BroadcastSlot* slot = slot_at((uint8_t*)spec->map, slot_size, n);
+  uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+  if (seq != 2 * n + 2) {
+    return -1;
+  }
+
+  uint32_t size = slot->size;
+  if (size < sizeof(BroadcastFrame) || size > slot_size - sizeof(*slot)) {
+    return -1;
+  }
+  memcpy(spec->frame, slot + 1, size);
+
+  atomic_thread_fence(memory_order_acquire);
+  return atomic_load_explicit(&slot->seq, memory_order_relaxed) == seq ? 1 : -1;
+}
+
+// Applies the copied frame to the snapshot, returns 0 when it does not fit
+// the board the snapshot was made for
+static int apply_frame(const Spectator* spec, GameSnapshot* snapshot) {
+  const BroadcastFrame* frame = (const BroadcastFrame*)spec->frame;
+  int keyframe = frame->flags & BROADCAST_KEYFRAME;
+  int total = snapshot->brick_total;
+  if (frame->balls > (uint32_t)snapshot->balls.capacity ||
+      frame->drops > (uint32_t)snapshot->drops.capacity ||
+      frame->bricks > (uint32_t)total ||
+      (keyframe && frame->bricks != (uint32_t)total)) {
+    return 0;
+  }
+
+  const uint8_t* bytes = (const uint8_t*)(frame + 1);
+  const uint32_t* changed = (const uint32_t*)bytes;
+  if (!keyframe) {
+    bytes += 4 * (size_t)frame->bricks;
+  }
+  const int16_t* ball_cells = (const int16_t*)bytes;
+  bytes += 4 * (size_t)frame->balls;
+  const int16_t* drop_cells = (const int16_t*)bytes;
+  const uint8_t* types = bytes + 4 * (size_t)frame->drops;
+  const uint8_t* health = types + frame->drops;
+
+  snapshot->paddle.rect.x = frame->paddle_x;
+  snapshot->paddle.rect.w = frame->paddle_w;
+
+  BallPool* balls = &snapshot->balls;
+  balls->count = frame->balls;
+  for (int i = 0; i < balls->count; i++) {
+    balls->x[i] = FIX_FROM_CELL(ball_cells[2 * i]);
+    balls->y[i] = FIX_FROM_CELL(ball_cells[2 * i + 1]);
+  }
+
+  // Dropping them the way a brick does picks their glyphs
+  DropPool* drops = &snapshot->drops;
+  drops->count = 0;
+  for (uint32_t i = 0; i < frame->drops; i++) {
+    Brick brick = {.drop = types[i]};
+    Rect at = {0};
+    if (spawn_drop(drops, &brick, &at)) {
+      drops->items[drops->count - 1].rect.x = drop_cells[2 * i];
+      drops->items[drops->count - 1].rect.y = drop_cells[2 * i + 1];
+    }
+  }
+
+  BrickBits* alive = &snapshot->alive;
+  if (keyframe) {
+    memset(alive->words, 0, sizeof(uint64_t) * alive->row_words * alive->rows);
+    for (int i = 0; i < total; i++) {
+      snapshot->health[i] = health[i];
+      if (health[i] > 0) {
+        set_brick_bit(alive, i);
+      }
+    }
+  } else {
+    for (uint32_t k = 0; k < frame->bricks; k++) {
+      uint32_t i = changed[k];
+      if (i >= (uint32_t)total) {
+        continue;
+      }
+      snapshot->health[i] = health[k];
+      if (health[k] > 0) {
+        set_brick_bit(alive, i);
+      } else {
+        clear_brick_bit(alive, i);
+      }
+    }
+  }
+
+  snapshot->scroll.shift = frame->shift;
+  snapshot->score = frame->score;
+  snapshot->paused = (frame->flags & BROADCAST_PAUSED) != 0;
+  return 1;
+}
+
+int spectator_read(Spectator* spec, GameSnapshot* snapshot) {
+  const BroadcastHeader* header = spec->header;
+  int changed = 0;
+
+  for (;;) {
+    uint64_t frames = atomic_load_explicit(&header->frames,
+                                           memory_order_acquire);
+    if (!spec->synced) {
+      // Deltas only apply on top of the frame before, so a spectator that
+      // just came in or lost frames starts over from the latest keyframe
+      if (frames == 0) {
+        break;
+      }
+      uint64_t keyframe = atomic_load_explicit(&header->keyframe,
+                                               memory_order_acquire);
+      if (spec->next > 0 && keyframe > spec->next) {
+        spec->skipped += keyframe - spec->next;
+      }
+      spec->next = keyframe;
+    }
+    if (spec->next >= frames) {
+      break;
+    }
+
+    if (copy_frame(spec, spec->next) < 0) {
+      spec->synced = 0;
+      continue;
+    }
+    const BroadcastFrame* frame = (const BroadcastFrame*)spec->frame;
+    if (!spec->synced && !(frame->flags & BROADCAST_KEYFRAME)) {
+      break;
+    }
+    if (!apply_frame(spec, snapshot)) {
+      break;
+    }
+    spec->synced = 1;
+    spec->next++;
+    changed = 1;
+  }
+
+  return changed;
+}
@@ -0,0 +1,122 @@
+#ifndef BROADCAST_H
+#define BROADCAST_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "replay.h"
+#include "snapshot.h"
+
+// A running game publishes every frame into a file mapped into memory, put
+// under /dev/shm it never touches a disk, and any number of spectators map
+// it read only and draw the frames. The file holds a header and a ring of
+// BROADCAST_SLOTS frames. A frame carries the paddle, the balls and the
+// drops in full and only the bricks whose health changed since the frame
+// before; every BROADCAST_KEYFRAME_INTERVAL frames, and whenever that is
+// smaller, a keyframe carries every brick instead.
+//
+// The publisher never waits for anyone: it writes each frame over the
+// oldest slot. Every slot has a sequence number that is odd while the slot
+// is written and 2 * (frame + 1) once frame is in it, so a spectator that
+// fell so far behind that its next frame was overwritten notices and skips
+// ahead to the latest keyframe.
+#define BROADCAST_MAGIC "BKCAST1"
+#define BROADCAST_VERSION 1
+#define BROADCAST_SLOTS 64
+#define BROADCAST_KEYFRAME_INTERVAL 30
+
+// BroadcastFrame.flags
+#define BROADCAST_KEYFRAME 1
+#define BROADCAST_PAUSED 2
+
+// How the file starts. The layout is what it takes to lay the board out the
+// way the game did, the frames only carry what moves.
+typedef struct {
+  char magic[8];  // written last, a half made file has none
+  uint32_t version;
+  uint32_t slot_size;  // bytes of a slot, its BroadcastSlot included
+  uint32_t slot_count;
+  ReplayHeader layout;  // the seed is the first round's
+
+  _Atomic uint64_t frames;    // published so far
+  _Atomic uint64_t keyframe;  // number of the latest keyframe
+  _Atomic int live;           // cleared when the game is over
+} BroadcastHeader;
+
+typedef struct {
+  _Atomic uint64_t seq;
+  uint32_t size;  // of the frame that follows
+  uint32_t unused;
+} BroadcastSlot;
+
+// A frame, followed by brick indices (uint32 each, only in a delta), ball
+// cells and drop cells (int16 x and y each), drop types and brick health
+// (one byte each)
+typedef struct {
+  uint32_t flags;
+  int32_t shift;  // how far an endless board has scrolled
+  int64_t score;
+  int32_t paddle_x;
+  int32_t paddle_w;
+  uint32_t balls;
+  uint32_t drops;
+  uint32_t bricks;  // changed bricks in a delta, every brick in a keyframe
+  uint32_t unused;
+} BroadcastFrame;
+
+// The game's side
+typedef struct {
+  const char* path;
+  uint8_t* map;
+  size_t size;
+  BroadcastHeader* header;
+
+  int* health;  // what the last frame left every brick with
+  int32_t shift;
+  int total;
+  uint64_t frame;
+  uint64_t keyframe;
+  uint64_t bytes;  // of every frame published
+} Broadcast;
+
+// Creates path and starts broadcasting the game into it, the layout is
+// taken from the header the game would be recorded with. Only a file an
+// earlier broadcast left there is replaced. Returns 0 and prints why when
+// path holds anything else or the file cannot be made.
+int broadcast_open(Broadcast* cast, const char* path, const Game* game,
+                   const ReplayHeader* layout);
+
+// Publishes the game's current state as the next frame
+void broadcast_publish(Broadcast* cast, const Game* game, int paused);
+
+// Tells the spectators the game is over and removes the file, the ones
+// still attached keep their mapping
+void broadcast_close(Broadcast* cast);
+
+// A spectator's side
+typedef struct {
+  const uint8_t* map;
+  size_t size;
+  const BroadcastHeader* header;
+  uint8_t* frame;  // the frame being applied, copied out of its slot
+  uint64_t next;   // number of the frame to read next
+  int synced;      // a keyframe was applied, deltas can follow
+  uint64_t skipped;  // frames lost by falling behind
+} Spectator;
+
+// Maps a broadcast, returns 0 and prints why when path is none
+int spectator_open(Spectator* spec, const char* path);
+
+void spectator_close(Spectator* spec);
+
+// Returns 1 while the game is still broadcasting
+int spectator_live(const Spectator* spec);
+
+// Applies every frame published since the last call to the snapshot, which
+// was made for the game laid out from the header and holds what the last
+// call left in it. Returns 1 when the snapshot changed.
+int spectator_read(Spectator* spec, GameSnapshot* snapshot);
+
+#endif
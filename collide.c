@@ -0,0 +1,303 @@
+#define _XOPEN_SOURCE 700
+
+#include "collide.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define HAVE_X86_KERNELS 1
+    #include <immintrin.h>
+#endif
+
+typedef void (*RangeKernel)(const PackedBricks*, int, int, const Rect*,
+                            uint32_t*);
+typedef uint32_t (*IndexedKernel)(const PackedBricks*, const int*, int,
+                                  const Rect*);
+
+static const char* kernel_names[KERNEL_COUNT] = {
+    [KERNEL_AUTO] = "auto",
+    [KERNEL_SCALAR] = "scalar",
+    [KERNEL_SSE2] = "sse2",
+    [KERNEL_AVX2] = "avx2",
+};
+
+// The far edges of the rect, precomputed once per call
+typedef struct {
+  int x;
+  int y;
+  int right;
+  int bottom;
+} RectEdges;
+
+static RectEdges rect_edges(const Rect* rect) {
+  return (RectEdges){rect->x, rect->y, rect->x + rect->w, rect->y + rect->h};
+}
+
+// A broken brick touches nothing, an endless board keeps it in place
+static int brick_touches(const PackedBricks* packed, int i,
+                         const RectEdges* e) {
+  return packed->health[i] > 0 &&
+         !(packed->x[i] + packed->w[i] < e->x ||  // brick is left of rect
+           packed->x[i] > e->right ||             // brick is right of rect
+           packed->y[i] + packed->h[i] < e->y ||  // brick is above rect
+           packed->y[i] > e->bottom);             // brick is below rect
+}
+
+static void range_scalar(const PackedBricks* packed, int first, int count,
+                         const Rect* rect, uint32_t* mask) {
+  RectEdges e = rect_edges(rect);
+  memset(mask, 0, sizeof(uint32_t) * ((count + 31) / 32));
+
+  for (int k = 0; k < count; k++) {
+    if (brick_touches(packed, first + k, &e)) {
+      mask[k / 32] |= 1u << (k % 32);
+    }
+  }
+}
+
+static uint32_t indexed_scalar(const PackedBricks* packed, const int* index,
+                               int count, const Rect* rect) {
+  RectEdges e = rect_edges(rect);
+  uint32_t mask = 0;
+
+  for (int k = 0; k < count; k++) {
+    if (brick_touches(packed, index[k], &e)) {
+      mask |= 1u << k;
+    }
+  }
+  return mask;
+}
+
+#ifdef HAVE_X86_KERNELS
+
+// Lanes where the brick is broken or misses the rect, the negation of
+// brick_touches
+static inline __m128i miss_sse2(__m128i x, __m128i y, __m128i w, __m128i h,
+                                __m128i health, const RectEdges* e) {
+  __m128i miss = _mm_cmplt_epi32(health, _mm_set1_epi32(1));
+  miss = _mm_or_si128(
+      miss, _mm_cmplt_epi32(_mm_add_epi32(x, w), _mm_set1_epi32(e->x)));
+  miss = _mm_or_si128(miss, _mm_cmpgt_epi32(x, _mm_set1_epi32(e->right)));
+  miss = _mm_or_si128(
+      miss, _mm_cmplt_epi32(_mm_add_epi32(y, h), _mm_set1_epi32(e->y)));
+  return _mm_or_si128(miss, _mm_cmpgt_epi32(y, _mm_set1_epi32(e->bottom)));
+}
+
+static inline uint32_t hits_sse2(__m128i miss) {
+  return (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(miss)) ^ 0xF;
+}
+
+static void range_sse2(const PackedBricks* packed, int first, int count,
+                       const Rect* rect, uint32_t* mask) {
+  RectEdges e = rect_edges(rect);
+  memset(mask, 0, sizeof(uint32_t) * ((count + 31) / 32));
+
+  int k = 0;
+  for (; k + 4 <= count; k += 4) {
+    int i = first + k;
+    __m128i miss = miss_sse2(_mm_loadu_si128((const __m128i*)(packed->x + i)),
+                             _mm_loadu_si128((const __m128i*)(packed->y + i)),
+                             _mm_loadu_si128((const __m128i*)(packed->w + i)),
+                             _mm_loadu_si128((const __m128i*)(packed->h + i)),
+                             _mm_loadu_si128(
+                                 (const __m128i*)(packed->health + i)),
+                             &e);
+    // Blocks of four never straddle a mask word
+    mask[k / 32] |= hits_sse2(miss) << (k % 32);
+  }
+
+  for (; k < count; k++) {
+    if (brick_touches(packed, first + k, &e)) {
+      mask[k / 32] |= 1u << (k % 32);
+    }
+  }
+}
+
+static uint32_t indexed_sse2(const PackedBricks* packed, const int* index,
+                             int count, const Rect* rect) {
+  RectEdges e = rect_edges(rect);
+  uint32_t mask = 0;
+
+  int k = 0;
+  for (; k + 4 <= count; k += 4) {
+    const int* ix = index + k;
+    __m128i x = _mm_setr_epi32(packed->x[ix[0]], packed->x[ix[1]],
+                               packed->x[ix[2]], packed->x[ix[3]]);
+    __m128i y = _mm_setr_epi32(packed->y[ix[0]], packed->y[ix[1]],
+                               packed->y[ix[2]], packed->y[ix[3]]);
+    __m128i w = _mm_setr_epi32(packed->w[ix[0]], packed->w[ix[1]],
+                               packed->w[ix[2]], packed->w[ix[3]]);
+    __m128i h = _mm_setr_epi32(packed->h[ix[0]], packed->h[ix[1]],
+                               packed->h[ix[2]], packed->h[ix[3]]);
+    __m128i health =
+        _mm_setr_epi32(packed->health[ix[0]], packed->health[ix[1]],
+                       packed->health[ix[2]], packed->health[ix[3]]);
+    mask |= hits_sse2(miss_sse2(x, y, w, h, health, &e)) << k;
+  }
+
+  for (; k < count; k++) {
+    if (brick_touches(packed, index[k], &e)) {
+      mask |= 1u << k;
+    }
+  }
+  return mask;
+}
+
+__attribute__((target("avx2"))) static inline __m256i miss_avx2(
+    __m256i x, __m256i y, __m256i w, __m256i h, __m256i health,
+    const RectEdges* e) {
+  __m256i miss = _mm256_cmpgt_epi32(_mm256_set1_epi32(1), health);
+  miss = _mm256_or_si256(miss, _mm256_cmpgt_epi32(_mm256_set1_epi32(e->x),
+                                                  _mm256_add_epi32(x, w)));
+  miss = _mm256_or_si256(miss,
+                         _mm256_cmpgt_epi32(x, _mm256_set1_epi32(e->right)));
+  miss = _mm256_or_si256(miss, _mm256_cmpgt_epi32(_mm256_set1_epi32(e->y),
+                                                  _mm256_add_epi32(y, h)));
+  return _mm256_or_si256(miss,
+                         _mm256_cmpgt_epi32(y, _mm256_set1_epi32(e->bottom)));
+}
+
+__attribute__((target("avx2"))) static inline uint32_t hits_avx2(
+    __m256i miss) {
+  return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(miss)) ^ 0xFF;
+}
+
+// Sixteen bricks per iteration, two registers of eight
+__attribute__((target("avx2"))) static void range_avx2(
+    const PackedBricks* packed, int first, int count, const Rect* rect,
+    uint32_t* mask) {
+  RectEdges e = rect_edges(rect);
+  memset(mask, 0, sizeof(uint32_t) * ((count + 31) / 32));
+
+  int k = 0;
+  for (; k + 16 <= count; k += 16) {
+    int i = first + k;
+    __m256i lo = miss_avx2(
+        _mm256_loadu_si256((const __m256i*)(packed->x + i)),
+        _mm256_loadu_si256((const __m256i*)(packed->y + i)),
+        _mm256_loadu_si256((const __m256i*)(packed->w + i)),
+        _mm256_loadu_si256((const __m256i*)(packed->h + i)),
+        _mm256_loadu_si256((const __m256i*)(packed->health + i)), &e);
+    __m256i hi = miss_avx2(
+        _mm256_loadu_si256((const __m256i*)(packed->x + i + 8)),
+        _mm256_loadu_si256((const __m256i*)(packed->y + i + 8)),
+        _mm256_loadu_si256((const __m256i*)(packed->w + i + 8)),
+        _mm256_loadu_si256((const __m256i*)(packed->h + i + 8)),
+        _mm256_loadu_si256((const __m256i*)(packed->health + i + 8)), &e);
+    mask[k / 32] |= (hits_avx2(lo) | (hits_avx2(hi) << 8)) << (k % 32);
+  }
+
+  for (; k < count; k++) {
+    if (brick_touches(packed, first + k, &e)) {
+      mask[k / 32] |= 1u << (k % 32);
+    }
+  }
+}
+
+// Gathers eight candidates per iteration
+__attribute__((target("avx2"))) static uint32_t indexed_avx2(
+    const PackedBricks* packed, const int* index, int count,
+    const Rect* rect) {
+  RectEdges e = rect_edges(rect);
+  uint32_t mask = 0;
+
+  int k = 0;
+  for (; k + 8 <= count; k += 8) {
+    __m256i ix = _mm256_loadu_si256((const __m256i*)(index + k));
+    __m256i miss = miss_avx2(_mm256_i32gather_epi32(packed->x, ix, 4),
+                             _mm256_i32gather_epi32(packed->y, ix, 4),
+                             _mm256_i32gather_epi32(packed->w, ix, 4),
+                             _mm256_i32gather_epi32(packed->h, ix, 4),
+                             _mm256_i32gather_epi32(packed->health, ix, 4),
+                             &e);
+    mask |= hits_avx2(miss) << k;
+  }
+
+  for (; k < count; k++) {
+    if (brick_touches(packed, index[k], &e)) {
+      mask |= 1u << k;
+    }
+  }
+  return mask;
+}
+
+#endif
+
+static CollideKernel active = KERNEL_AUTO;
+static RangeKernel range_kernel = range_scalar;
+static IndexedKernel indexed_kernel = indexed_scalar;
+
+static int kernel_supported(CollideKernel kernel) {
+  switch (kernel) {
+    case KERNEL_SCALAR:
+      return 1;
+#ifdef HAVE_X86_KERNELS
+    case KERNEL_SSE2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2");
+    case KERNEL_AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return 0;
+  }
+}
+
+int collide_select_kernel(CollideKernel kernel) {
+  if (kernel == KERNEL_AUTO) {
+    kernel = KERNEL_SCALAR;
+    for (int k = KERNEL_COUNT - 1; k > KERNEL_SCALAR; k--) {
+      if (kernel_supported(k)) {
+        kernel = k;
+        break;
+      }
+    }
+  }
+
+  if (!kernel_supported(kernel)) {
+    return 0;
+  }
+
+  switch (kernel) {
+#ifdef HAVE_X86_KERNELS
+    case KERNEL_SSE2:
+      range_kernel = range_sse2;
+      indexed_kernel = indexed_sse2;
+      break;
+    case KERNEL_AVX2:
+      range_kernel = range_avx2;
+      indexed_kernel = indexed_avx2;
+      break;
+#endif
+    default:
+      range_kernel = range_scalar;
+      indexed_kernel = indexed_scalar;
+      break;
+  }
+
+  active = kernel;
+  return 1;
+}
+
+// Picks the kernel when the program is loaded, before any thread can step a
+// game, so the kernels are only ever read while games are stepped
+__attribute__((constructor)) static void select_best_kernel(void) {
+  collide_select_kernel(KERNEL_AUTO);
+}
+
+CollideKernel collide_active_kernel(void) { return active; }
+
+const char* collide_kernel_name(CollideKernel kernel) {
+  return kernel_names[kernel];
+}
+
+void bricks_hit_mask(const PackedBricks* packed, int first, int count,
+                     const Rect* rect, uint32_t* mask) {
+  range_kernel(packed, first, count, rect, mask);
+}
+
+uint32_t bricks_hit_mask_indexed(const PackedBricks* packed, const int* index,
+                                 int count, const Rect* rect) {
+  return indexed_kernel(packed, index, count, rect);
+}
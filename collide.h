@@ -0,0 +1,39 @@
+#ifndef COLLIDE_H
+#define COLLIDE_H
+
+#include <stdint.h>
+
+#include "game.h"
+
+// Which implementation of the batch collision kernel is in use
+typedef enum {
+  KERNEL_AUTO,
+  KERNEL_SCALAR,
+  KERNEL_SSE2,
+  KERNEL_AVX2,
+  KERNEL_COUNT
+} CollideKernel;
+
+// Tests rect against the bricks first .. first + count - 1 and sets bit k of
+// the mask (bit k % 32 of word k / 32) when brick first + k has health left
+// and touches it, with the same inclusive edges as is_colliding. The mask
+// must hold (count + 31) / 32 words.
+void bricks_hit_mask(const PackedBricks* packed, int first, int count,
+                     const Rect* rect, uint32_t* mask);
+
+// Same as bricks_hit_mask for up to 32 bricks picked by index, bit k stands
+// for brick index[k]
+uint32_t bricks_hit_mask_indexed(const PackedBricks* packed, const int* index,
+                                 int count, const Rect* rect);
+
+// Forces an implementation, KERNEL_AUTO picks the best one the CPU supports,
+// which is what a program starts with. Not while any thread steps a game.
+// Returns 0 when the requested one is not available.
+int collide_select_kernel(CollideKernel kernel);
+
+// Returns the implementation currently in use
+CollideKernel collide_active_kernel(void);
+
+const char* collide_kernel_name(CollideKernel kernel);
+
+#endif
@@ -0,0 +1,138 @@
+#include "effects.h"
+
+#include <stdio.h>
+
+// Pull on the debris per frame, fixed point cells per frame
+#define DEBRIS_GRAVITY (FIX_ONE / 8)
+
+void default_effects_config(EffectsConfig* config) {
+  config->max_particles = DEFAULT_MAX_PARTICLES;
+  config->budget_ns = DEFAULT_EFFECTS_BUDGET_US * 1000ULL;
+}
+
+void effects_init(EffectPool* pool, const EffectsConfig* config,
+                  const Rect* bounds, Arena* arena) {
+  int capacity = config->max_particles > 0 ? config->max_particles : 0;
+  size_t slots = capacity + 1;
+  pool->x = arena_alloc(arena, sizeof(int) * slots);
+  pool->y = arena_alloc(arena, sizeof(int) * slots);
+  pool->vx = arena_alloc(arena, sizeof(int) * slots);
+  pool->vy = arena_alloc(arena, sizeof(int) * slots);
+  pool->value = arena_alloc(arena, sizeof(int) * slots);
+  pool->w = arena_alloc(arena, slots);
+  pool->life = arena_alloc(arena, slots);
+  pool->kind = arena_alloc(arena, slots);
+  pool->count = 0;
+  pool->capacity = capacity;
+
+  pool->bounds = *bounds;
+  rng_seed(&pool->rng, 1);
+
+  pool->budget_ns = config->budget_ns;
+  pool->scale = EFFECTS_SCALE_FULL;
+  pool->spawned = 0;
+  pool->skipped = 0;
+}
+
+// Appends a particle at cell (x, y) and returns its index, the caller made
+// sure there is room
+static int add_particle(EffectPool* pool, ParticleKind kind, int x, int y,
+                        int w, int life) {
+  int i = pool->count++;
+  pool->x[i] = FIX_FROM_CELL(x);
+  pool->y[i] = FIX_FROM_CELL(y);
+  pool->vx[i] = 0;
+  pool->vy[i] = 0;
+  pool->value[i] = 0;
+  pool->w[i] = w;
+  pool->life[i] = life;
+  pool->kind[i] = kind;
+  return i;
+}
+
+void effects_brick_broken(EffectPool* pool, const Rect* rect, int points) {
+  // The popup is the first thing to go once the budget bites, then the
+  // debris thins out, and a full pool takes what still fits
+  int popup = pool->scale >= EFFECTS_SCALE_FULL / 2;
+  int debris = EFFECTS_DEBRIS_PER_BRICK * pool->scale / EFFECTS_SCALE_FULL;
+  if (debris == 0 && pool->scale > 0) {
+    debris = 1;  // a break still shows while any rate is left
+  }
+  int room = pool->capacity - pool->count;
+  if (debris > room) {
+    debris = room;
+  }
+  if (popup > room - debris) {
+    popup = 0;
+  }
+  pool->spawned += debris + popup;
+  pool->skipped += EFFECTS_DEBRIS_PER_BRICK + 1 - debris - popup;
+
+  for (int n = 0; n < debris; n++) {
+    int x = rect->x + rng_below(&pool->rng, rect->w > 0 ? rect->w : 1);
+    int i = add_particle(pool, PARTICLE_DEBRIS, x, rect->y, 1,
+                         EFFECTS_DEBRIS_FRAMES);
+    pool->vx[i] = rng_below(&pool->rng, 2 * FIX_ONE + 1) - FIX_ONE;
+    pool->vy[i] = -rng_below(&pool->rng, FIX_ONE + 1);
+  }
+
+  if (popup) {
+    char text[16];
+    int w = snprintf(text, sizeof(text), "+%d", points);
+    int i = add_particle(pool, PARTICLE_POPUP, rect->x + (rect->w - w) / 2,
+                         rect->y, w, EFFECTS_POPUP_FRAMES);
+    pool->vy[i] = -FIX_ONE / 4;
+    pool->value[i] = points;
+  }
+}
+
+void effects_update(EffectPool* pool) {
+  int count = pool->count;
+
+  // Moving is the same few adds for every particle, one branch-free pass the
+  // compiler can vectorize
+  for (int i = 0; i < count; i++) {
+    pool->vy[i] += pool->kind[i] == PARTICLE_DEBRIS ? DEBRIS_GRAVITY : 0;
+    pool->x[i] += pool->vx[i];
+    pool->y[i] += pool->vy[i];
+    pool->life[i]--;
+  }
+
+  // Then the live ones are packed down in order, skipping the burnt out ones
+  // and those that left the bounds
+  const Rect* bounds = &pool->bounds;
+  int left = FIX_FROM_CELL(bounds->x);
+  int top = FIX_FROM_CELL(bounds->y);
+  int bottom = FIX_FROM_CELL(bounds->y + bounds->h);
+  int kept = 0;
+  for (int i = 0; i < count; i++) {
+    int right = FIX_FROM_CELL(bounds->x + bounds->w - pool->w[i]);
+    if (pool->life[i] == 0 || pool->x[i] < left || pool->x[i] > right ||
+        pool->y[i] < top || pool->y[i] >= bottom) {
+      continue;
+    }
+    if (kept != i) {
+      pool->x[kept] = pool->x[i];
+      pool->y[kept] = pool->y[i];
+      pool->vx[kept] = pool->vx[i];
+      pool->vy[kept] = pool->vy[i];
+      pool->value[kept] = pool->value[i];
+      pool->w[kept] = pool->w[i];
+      pool->life[kept] = pool->life[i];
+      pool->kind[kept] = pool->kind[i];
+    }
+    kept++;
+  }
+  pool->count = kept;
+}
+
+void effects_account(EffectPool* pool, uint64_t ns) {
+  if (ns > pool->budget_ns) {
+    pool->scale /= 2;
+  } else if (pool->scale < EFFECTS_SCALE_FULL) {
+    pool->scale += EFFECTS_SCALE_FULL / 16;
+    if (pool->scale > EFFECTS_SCALE_FULL) {
+      pool->scale = EFFECTS_SCALE_FULL;
+    }
+  }
+}
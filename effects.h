@@ -0,0 +1,83 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <stdint.h>
+
+#include "arena.h"
+#include "game.h"
+#include "rng.h"
+
+// Debris thrown out of a broken brick while the effects are within budget
+#define EFFECTS_DEBRIS_PER_BRICK 6
+
+// Frames a piece of debris and a score popup stay on screen
+#define EFFECTS_DEBRIS_FRAMES 10
+#define EFFECTS_POPUP_FRAMES 14
+
+#define DEFAULT_MAX_PARTICLES 512
+#define DEFAULT_EFFECTS_BUDGET_US 1000
+
+// EffectPool.scale when every particle asked for is spawned
+#define EFFECTS_SCALE_FULL 256
+
+typedef struct {
+  int max_particles;   // 0 turns the effects off
+  uint64_t budget_ns;  // a frame's share for updating and drawing them
+} EffectsConfig;
+
+typedef enum {
+  PARTICLE_DEBRIS,
+  PARTICLE_POPUP  // the points a brick gave, drawn as text
+} ParticleKind;
+
+// Purely visual particles, owned by the renderer and never seen by the
+// simulation. The pool is fixed size and kept as parallel arrays so a frame
+// moves all of them in one linear pass, then packs the live ones down.
+// When a frame spends more than its budget on them the pool spawns fewer
+// from then on, and earns the rate back while it stays under.
+typedef struct {
+  int* x;  // top left corner, fixed point
+  int* y;
+  int* vx;  // fixed point cells per frame
+  int* vy;
+  int* value;  // the points of a popup
+  uint8_t* w;  // cells covered
+  uint8_t* life;  // frames left
+  uint8_t* kind;
+  int count;
+  int capacity;
+
+  Rect bounds;  // particles that leave it are dropped
+  Rng rng;
+
+  uint64_t budget_ns;
+  int scale;  // share of EFFECTS_SCALE_FULL of the particles asked for
+  uint64_t spawned;
+  uint64_t skipped;  // particles not spawned, for the budget or a full pool
+} EffectPool;
+
+void default_effects_config(EffectsConfig* config);
+
+// Carves the pool out of the arena, particles stay within bounds
+void effects_init(EffectPool* pool, const EffectsConfig* config,
+                  const Rect* bounds, Arena* arena);
+
+// Throws debris out of a brick that broke where rect is, and a popup with
+// its points above it
+void effects_brick_broken(EffectPool* pool, const Rect* rect, int points);
+
+// Moves every particle on by a frame and drops the burnt out ones
+void effects_update(EffectPool* pool);
+
+// Takes the time a frame spent on the effects: over the budget halves the
+// spawn rate, under it the rate grows back a step at a time. Call it every
+// frame, also when no particle is alive, or a cut rate never recovers.
+void effects_account(EffectPool* pool, uint64_t ns);
+
+// Returns the cells covered by particle i
+static inline Rect particle_rect(const EffectPool* pool, int i) {
+  return (Rect){FIX_TO_CELL(pool->x[i]), FIX_TO_CELL(pool->y[i]), pool->w[i],
+                1};
+}
+
+#endif
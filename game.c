@@ -0,0 +1,1076 @@
+#define _XOPEN_SOURCE 700
+
+#include "game.h"
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "collide.h"
+#include "timing.h"
+#include "workers.h"
+
+static const char* phase_names[PHASE_COUNT] = {
+    [PHASE_PADDLE] = "paddle",
+    [PHASE_BRICKS] = "resolve_balls_brick_collision",
+    [PHASE_BOUNDS] = "keep_balls_within_bounds",
+    [PHASE_BALLS] = "update_balls",
+    [PHASE_DROPS] = "update_drops",
+};
+
+const char* game_phase_name(GamePhase phase) { return phase_names[phase]; }
+
+static const char* event_names[EVENT_TYPE_COUNT] = {
+    [EVENT_BRICK_DAMAGED] = "brick_damaged",
+    [EVENT_BRICK_DESTROYED] = "brick_destroyed",
+    [EVENT_DROP_SPAWNED] = "drop_spawned",
+    [EVENT_DROP_CAUGHT] = "drop_caught",
+    [EVENT_BALL_LOST] = "ball_lost",
+};
+
+const char* game_event_name(GameEventType type) { return event_names[type]; }
+
+void init_win_conf(WindowConfig* win_conf, int width, int height) {
+  win_conf->padding.x = 0;
+  win_conf->padding.y = 0;
+
+  win_conf->rect.w = width;
+  win_conf->rect.h = height;
+
+  win_conf->inner_rect.w = get_inner_window_width(win_conf);
+  win_conf->inner_rect.h = get_inner_window_height(win_conf);
+
+  win_conf->rect.x = 0;
+  win_conf->rect.y = 0;
+
+  win_conf->inner_rect.x = win_conf->padding.x + 1;
+  win_conf->inner_rect.y = win_conf->padding.y + 1;
+}
+
+void default_game_config(GameConfig* config) {
+  config->brick_cols = BRICK_COUTN;
+  config->brick_rows = BRICK_ROWS;
+  config->max_balls = MAX_BALLS;
+  config->max_events = EVENT_QUEUE_CAPACITY;
+  config->level = NULL;
+  config->seed = 1;
+  config->ball_speed = DEFAULT_BALL_SPEED;
+  config->tick_rate = DEFAULT_TICK_RATE;
+  config->scroll_period = 0;
+}
+
+int endless_scroll_period(int tick_rate) {
+  int period = tick_rate * ENDLESS_SCROLL_MS / 1000;
+  return period > 0 ? period : 1;
+}
+
+// Fills the cells of a board with random bricks
+static void random_cells(uint8_t* cells, int count, Rng* rng) {
+  for (int i = 0; i < count; i++) {
+    int health = get_random_health(rng);
+    cells[i] = LEVEL_CELL(health, get_random_drop(rng));
+  }
+}
+
+// Returns about how much arena a round takes, the brick grid is only known
+// once the bricks are laid out so it is sized for the smallest cells
+static size_t round_arena_size(const WindowConfig* win_conf, int brick_total,
+                               const GameConfig* config) {
+  size_t bricks = brick_total + 1;
+  size_t grid_cells = (size_t)(win_conf->rect.w + 2) * (win_conf->rect.h + 2);
+  return bricks * (1 + sizeof(Brick) + sizeof(int) * 5 + sizeof(Drop)) +
+         (size_t)(config->max_balls + 1) * (sizeof(int) * 4 + 1) +
+         (size_t)(config->max_events + 1) * sizeof(GameEvent) +
+         (grid_cells + 1) * sizeof(int) +
+         bricks * (sizeof(int) * 5 + sizeof(unsigned) + sizeof(uint64_t)) +
+         64 * alignof(max_align_t);
+}
+
+// Carves the round out of the game's arena and sets it up
+static void layout_game(Game* game, const WindowConfig* win_conf,
+                        const GameConfig* config) {
+  Arena* arena = &game->arena;
+  game->win_conf = *win_conf;
+
+  const Level* level = config->level;
+  game->brick_cols = level ? level->cols : config->brick_cols;
+  game->brick_rows = level ? level->rows : config->brick_rows;
+  game->brick_total = game->brick_cols * game->brick_rows;
+
+  // Everything a round needs is allocated here once, reset_game only
+  // rewrites it
+  game->random_cells = NULL;
+  if (level == NULL) {
+    game->random_cells = arena_alloc(arena, game->brick_total + 1);
+  }
+
+  init_ball_pool(&game->balls, config->max_balls, arena);
+  game->bricks = arena_calloc(arena, game->brick_total + 1, sizeof(Brick));
+  init_packed_bricks(&game->packed, game->brick_cols, game->brick_rows,
+                     arena);
+  init_drop_pool(&game->drops, game->brick_total, arena);
+  init_event_queue(&game->events, config->max_events, arena);
+
+  // An endless board's rows turn through the band they were laid out in,
+  // which runs from the gap above the first row to the one below the last
+  BrickScroll* scroll = &game->packed.scroll;
+  *scroll = (BrickScroll){0};
+  if (config->scroll_period > 0) {
+    scroll->top = win_conf->inner_rect.y + BRICK_V_GAP - 1;
+    scroll->height = game->brick_rows * (1 + BRICK_V_GAP);
+  }
+
+  reset_game(game, config);
+
+  // The brick layout only depends on the window and the level, so the grid
+  // outlives every reset
+  init_brick_grid(&game->grid, &game->win_conf, &game->packed, arena);
+}
+
+int board_fits(const WindowConfig* win_conf, const GameConfig* config) {
+  const Level* level = config->level;
+  int cols = level ? level->cols : config->brick_cols;
+  int rows = level ? level->rows : config->brick_rows;
+
+  // The same sums init_bricks and init_paddle lay the board out with
+  int glyph = glyph_width(GLYPH_BRICK_STRONG);
+  int usable_width = win_conf->inner_rect.w - (cols - 1) * BRICK_H_GAP;
+  int brick_width = cols > 0 ? (usable_width / cols) / glyph : 0;
+  if (brick_width < 1) {
+    fprintf(stderr,
+            "Error: %d columns of bricks do not fit a %d wide window, the "
+            "most that do are %d\n",
+            cols, win_conf->rect.w,
+            (win_conf->inner_rect.w + BRICK_H_GAP) / (glyph + BRICK_H_GAP));
+    return 0;
+  }
+
+  int last_row = win_conf->inner_rect.y + (rows - 1) + BRICK_V_GAP * rows;
+  int ball_row = win_conf->inner_rect.h - 1;
+  if (last_row >= ball_row) {
+    fprintf(stderr,
+            "Error: %d rows of bricks do not fit a %d high window, the most "
+            "that do are %d\n",
+            rows, win_conf->rect.h,
+            (ball_row - win_conf->inner_rect.y) / (1 + BRICK_V_GAP));
+    return 0;
+  }
+  return 1;
+}
+
+void init_game(Game* game, const WindowConfig* win_conf,
+               const GameConfig* config) {
+  const Level* level = config->level;
+  int brick_total = level ? level->cols * level->rows
+                          : config->brick_cols * config->brick_rows;
+  arena_init(&game->arena, round_arena_size(win_conf, brick_total, config));
+  game->profile = NULL;
+  game->workers = NULL;
+  layout_game(game, win_conf, config);
+}
+
+void restart_game(Game* game, const WindowConfig* win_conf,
+                  const GameConfig* config) {
+  arena_reset(&game->arena);
+  layout_game(game, win_conf, config);
+}
+
+void reset_game(Game* game, const GameConfig* config) {
+  rng_seed(&game->rng, config->seed);
+
+  Level random;
+  const Level* level = config->level;
+  if (level == NULL) {
+    random_cells(game->random_cells, game->brick_total, &game->rng);
+    random = (Level){.cols = game->brick_cols,
+                     .rows = game->brick_rows,
+                     .cells = game->random_cells};
+    level = &random;
+  }
+
+  init_paddle(&game->paddle, &game->win_conf);
+  game->balls.count = 0;
+  game->balls.speed = config->ball_speed * FIX_ONE / config->tick_rate;
+  add_ball(&game->balls, &game->paddle);
+
+  init_bricks(&game->win_conf, game->bricks, &game->packed, level);
+  game->packed.scroll.shift = 0;
+  game->scroll_period = config->scroll_period;
+  game->scroll_timer = 0;
+  game->drops.count = 0;
+  clear_events(&game->events);
+
+  game->score = 0;
+  game->game_over = 0;
+  game->win = 0;
+}
+
+void free_game(Game* game) {
+  arena_free(&game->arena);
+  game->bricks = NULL;
+  game->random_cells = NULL;
+  memset(&game->balls, 0, sizeof(game->balls));
+  memset(&game->packed, 0, sizeof(game->packed));
+  memset(&game->grid, 0, sizeof(game->grid));
+  memset(&game->drops, 0, sizeof(game->drops));
+  memset(&game->events, 0, sizeof(game->events));
+}
+
+// Adds the time since *start to the given phase of the tick and restarts the
+// clock
+static void profile_phase(Game* game, GamePhase phase, uint64_t* start,
+                          uint64_t* spent) {
+  if (game->profile == NULL) {
+    return;
+  }
+
+  uint64_t now = now_ns();
+  spent[phase] += now - *start;
+  *start = now;
+}
+
+// Adds the phases of a finished tick to the profile
+static void profile_tick(Game* game, const uint64_t* spent) {
+  GameProfile* profile = game->profile;
+  if (profile == NULL) {
+    return;
+  }
+
+  for (int i = 0; i < PHASE_COUNT; i++) {
+    profile->ns[i] += spent[i];
+    if (profile->hist) {
+      hist_record(&profile->hist[i], spent[i]);
+    }
+  }
+  profile->ticks++;
+}
+
+// Adds up the points for the events queued since first
+static void score_events(Game* game, int first) {
+  const EventQueue* events = &game->events;
+  for (int i = first; i < events->count; i++) {
+    switch (events->items[i].type) {
+      case EVENT_BRICK_DAMAGED:
+        game->score += SCORE_BRICK_DAMAGED;
+        break;
+      case EVENT_BRICK_DESTROYED:
+        game->score += SCORE_BRICK_DESTROYED;
+        break;
+      case EVENT_DROP_CAUGHT:
+        game->score += SCORE_DROP_CAUGHT;
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+// Gives a row of the board new random bricks, whatever was left of the old
+// ones is gone
+static void refill_brick_row(Game* game, int row) {
+  PackedBricks* packed = &game->packed;
+  uint64_t* words = brick_bits_row(&packed->alive, row);
+  for (int w = 0; w < packed->alive.row_words; w++) {
+    packed->live -= __builtin_popcountll(words[w]);
+    words[w] = 0;
+  }
+
+  for (int col = 0; col < game->brick_cols; col++) {
+    int index = row * game->brick_cols + col;
+    int health = get_random_health(&game->rng);
+    int drop = get_random_drop(&game->rng);
+    packed->health[index] = health;
+    game->bricks[index].drop = health > 0 ? drop : DROP_NONE;
+    if (health > 0) {
+      set_brick_bit(&packed->alive, index);
+      packed->live++;
+    }
+  }
+}
+
+// The band only wraps cleanly between gap rows with one on either side of
+// every brick row
+_Static_assert(BRICK_V_GAP >= 2, "an endless board needs two gap rows");
+
+// Moves an endless board down a row. The brick row that wraps around to the
+// top of the band is the one that fell off the bottom, it comes back as a new
+// row, so scrolling never touches more than one row of bricks.
+static void scroll_bricks(Game* game) {
+  BrickScroll* scroll = &game->packed.scroll;
+  scroll->shift = (scroll->shift + 1) % scroll->height;
+
+  // Every row is laid out one row below the start of its stretch of the band
+  int ring = (scroll->height - scroll->shift) % scroll->height;
+  if (ring % (1 + BRICK_V_GAP) == 1) {
+    refill_brick_row(game, ring / (1 + BRICK_V_GAP));
+  }
+}
+
+void game_step(Game* game, const GameInput* input) {
+  uint64_t start = game->profile ? now_ns() : 0;
+  uint64_t spent[PHASE_COUNT] = {0};
+  int first_event = game->events.count;
+
+  game->paddle.dir.x = input->paddle_dir;
+
+  if (input->launch) {
+    BallPool* balls = &game->balls;
+    for (int i = 0; i < balls->count; i++) {
+      if (balls->launched[i] == 0) {
+        balls->launched[i] = 1;
+        aim_ball(balls, i, get_random_spin(&game->rng));
+      }
+    }
+  }
+
+  game->paddle.rect.x += game->paddle.dir.x;
+  clamp_paddle_bounds(&game->win_conf, &game->paddle);
+  profile_phase(game, PHASE_PADDLE, &start, spent);
+
+  // Every sub-step tests the balls where they are now, a fast ball meets the
+  // bricks, walls and paddle on the way instead of skipping past them
+  int steps = ball_substeps(&game->balls);
+  for (int step = 0; step < steps; step++) {
+    if (game->workers) {
+      // The threads move the balls and find their hits, which are applied
+      // here in ball order just as the serial pass does. The moves are
+      // counted with the bricks.
+      StepWorkers* workers = game->workers;
+      step_workers_find_hits(workers, step, steps);
+      for (int i = 0; i < game->balls.count; i++) {
+        apply_ball_hits(game->bricks, &game->packed, &game->balls, i,
+                        workers->hits + (size_t)i * MAX_BALL_HITS,
+                        workers->hit_count[i], &game->drops, &game->events);
+      }
+    } else {
+      move_balls(&game->balls, step, steps);
+      profile_phase(game, PHASE_BALLS, &start, spent);
+
+      resolve_balls_brick_collision(game->bricks, &game->packed, &game->grid,
+                                    &game->balls, &game->drops,
+                                    &game->events);
+    }
+    profile_phase(game, PHASE_BRICKS, &start, spent);
+
+    keep_balls_within_bounds(&game->win_conf, &game->balls);
+    profile_phase(game, PHASE_BOUNDS, &start, spent);
+
+    update_balls(&game->win_conf, &game->balls, &game->paddle, &game->events);
+    profile_phase(game, PHASE_BALLS, &start, spent);
+  }
+
+  update_drops(&game->win_conf, &game->drops, &game->paddle, &game->balls,
+               &game->events);
+  profile_phase(game, PHASE_DROPS, &start, spent);
+
+  if (game->scroll_period > 0 &&
+      ++game->scroll_timer >= game->scroll_period) {
+    game->scroll_timer = 0;
+    scroll_bricks(game);
+  }
+  profile_phase(game, PHASE_BRICKS, &start, spent);
+
+  score_events(game, first_event);
+
+  if (game->balls.count == 0) {
+    game->game_over = 1;
+  }
+
+  // An endless board is never cleared for good
+  if (game->scroll_period == 0 && all_bricks_destroyed(&game->packed)) {
+    game->win = 1;
+    game->game_over = 1;
+  }
+
+  profile_tick(game, spent);
+}
+
+static uint32_t hash_ints(uint32_t hash, const int* values, int count) {
+  for (int i = 0; i < count; i++) {
+    hash = (hash ^ (uint32_t)values[i]) * 16777619u;
+  }
+  return hash;
+}
+
+uint32_t game_state_hash(const Game* game) {
+  const BallPool* balls = &game->balls;
+  int paddle[] = {game->paddle.rect.x, game->paddle.rect.w, balls->count,
+                  game->drops.count, (int)game->score,
+                  game->packed.scroll.shift, game->scroll_timer};
+
+  uint32_t hash = hash_ints(2166136261u, paddle, 7);
+  hash = hash_ints(hash, balls->x, balls->count);
+  hash = hash_ints(hash, balls->y, balls->count);
+  hash = hash_ints(hash, balls->vx, balls->count);
+  hash = hash_ints(hash, balls->vy, balls->count);
+  hash = hash_ints(hash, game->packed.health, game->packed.count);
+  for (int i = 0; i < game->drops.count; i++) {
+    const Drop* drop = &game->drops.items[i];
+    int values[] = {drop->rect.x, drop->rect.y, drop->type};
+    hash = hash_ints(hash, values, 3);
+  }
+  return hash;
+}
+
+void init_paddle(Paddle* paddle, WindowConfig* win_conf) {
+  paddle->glyph = GLYPH_PADDLE;
+  paddle->char_width = glyph_width(GLYPH_PADDLE);
+
+  // paddle->rect.w = MAX_PADDLE_SIZE * paddle->char_width;
+  paddle->rect.w =
+      ((MAX_PADDLE_SIZE + MIN_PADDLE_SIZE) / 2) * paddle->char_width;
+  paddle->rect.h = 1;
+
+  paddle->rect.x = get_center_offset(win_conf->inner_rect.w, paddle->rect.w);
+  paddle->rect.y = win_conf->inner_rect.h;
+
+  paddle->dir.x = 0;
+  paddle->dir.y = 0;
+}
+
+void clamp_paddle_bounds(WindowConfig* win_conf, Paddle* paddle) {
+  if (paddle->rect.x < win_conf->inner_rect.x) {
+    paddle->rect.x = win_conf->inner_rect.x;
+  }
+
+  if (paddle->rect.x + paddle->rect.w > win_conf->inner_rect.w) {
+    paddle->rect.x = win_conf->rect.w - paddle->rect.w - 1;
+  }
+}
+
+void init_ball_pool(BallPool* balls, int capacity, Arena* arena) {
+  if (capacity < 1) {
+    capacity = 1;
+  }
+
+  // One block for all the arrays, the int arrays first so they stay aligned
+  size_t ints = sizeof(int) * capacity;
+  char* block = arena_alloc(arena, ints * 4 + capacity);
+
+  balls->x = (int*)block;
+  balls->y = (int*)(block + ints);
+  balls->vx = (int*)(block + ints * 2);
+  balls->vy = (int*)(block + ints * 3);
+  balls->launched = (unsigned char*)(block + ints * 4);
+  balls->count = 0;
+  balls->capacity = capacity;
+  balls->speed = FIX_ONE;
+
+  balls->glyph = GLYPH_BALL;
+  balls->w = glyph_width(GLYPH_BALL);
+  balls->h = 1;
+}
+
+void init_ball(BallPool* balls, int i, Paddle* paddle) {
+  balls->vx[i] = 0;
+  balls->vy[i] = 0;
+
+  balls->x[i] = FIX_FROM_CELL(paddle->rect.x + (paddle->rect.w / 3));
+  balls->y[i] = FIX_FROM_CELL(paddle->rect.y - 1);
+
+  balls->launched[i] = 0;
+}
+
+int add_ball(BallPool* balls, Paddle* paddle) {
+  if (balls->count == balls->capacity) {
+    return -1;
+  }
+
+  init_ball(balls, balls->count, paddle);
+  return balls->count++;
+}
+
+void remove_ball(BallPool* balls, int i) {
+  int last = --balls->count;
+  balls->x[i] = balls->x[last];
+  balls->y[i] = balls->y[last];
+  balls->vx[i] = balls->vx[last];
+  balls->vy[i] = balls->vy[last];
+  balls->launched[i] = balls->launched[last];
+}
+
+int ball_substeps(const BallPool* balls) {
+  int steps = (balls->speed + FIX_ONE - 1) / FIX_ONE;
+  return steps > 1 ? steps : 1;
+}
+
+void move_balls(BallPool* balls, int step, int steps) {
+  for (int i = 0; i < balls->count; i++) {
+    move_ball(balls, i, step, steps);
+  }
+}
+
+void update_balls(WindowConfig* win_conf, BallPool* balls, Paddle* paddle,
+                  EventQueue* events) {
+  for (int i = 0; i < balls->count; i++) {
+    Rect rect = ball_rect(balls, i);
+    if (balls->launched[i] && balls->vy[i] > 0 &&
+        is_colliding(&rect, &paddle->rect)) {
+      deflect_ball(balls, i, &paddle->rect);
+    }
+
+    if (balls->launched[i] == 0) {
+      balls->x[i] = FIX_FROM_CELL(paddle->rect.x + (paddle->rect.w / 2) - 1);
+      balls->y[i] = FIX_FROM_CELL(paddle->rect.y - 1);
+    }
+
+    if (FIX_TO_CELL(balls->y[i]) >= win_conf->inner_rect.h) {
+      // The last ball now sits in slot i and still has to be checked
+      remove_ball(balls, i);
+      push_event(events, EVENT_BALL_LOST, -1, balls->count);
+      i--;
+    }
+  }
+}
+
+void keep_balls_within_bounds(WindowConfig* win_conf, BallPool* balls) {
+  for (int i = 0; i < balls->count; i++) {
+    int x = FIX_TO_CELL(balls->x[i]);
+    int y = FIX_TO_CELL(balls->y[i]);
+
+    // Only turn a ball that is still heading out, one that already turned
+    // may need a few sub-steps to leave the edge cell
+    if ((x <= win_conf->inner_rect.x && balls->vx[i] < 0) ||
+        (x >= win_conf->inner_rect.w && balls->vx[i] > 0)) {
+      balls->vx[i] = -balls->vx[i];
+    }
+
+    if (y <= win_conf->inner_rect.y && balls->vy[i] < 0) {
+      balls->vy[i] = -balls->vy[i];
+    }
+  }
+}
+
+int get_random_spin(Rng* rng) {
+  return (int)rng_below(rng, 2 * FIX_ONE + 1) - FIX_ONE;
+}
+
+int get_random_drop(Rng* rng) {
+  return rng_below(rng, 4);
+}
+
+int get_random_health(Rng* rng) { return rng_below(rng, 3) + 1; }
+
+// Integer square root, rounded down
+static int64_t isqrt(int64_t value) {
+  int64_t root = 0;
+  int64_t bit = (int64_t)1 << 62;
+  while (bit > value) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+void aim_ball(BallPool* balls, int i, int spin) {
+  if (spin < -FIX_ONE) {
+    spin = -FIX_ONE;
+  } else if (spin > FIX_ONE) {
+    spin = FIX_ONE;
+  }
+
+  // The sideways part follows the spin, the rest of the speed goes up
+  int64_t speed = balls->speed;
+  int64_t vx = speed * BALL_MAX_SIDEWAYS * spin / (100 * FIX_ONE);
+  balls->vx[i] = (int)vx;
+  balls->vy[i] = (int)-isqrt(speed * speed - vx * vx);
+}
+
+void deflect_ball(BallPool* balls, int i, const Rect* paddle) {
+  // How far off the paddle's middle the ball's middle is, as a share of
+  // half the paddle
+  int half = FIX_FROM_CELL(paddle->w) / 2;
+  int middle = FIX_FROM_CELL(paddle->x) + half;
+  int center = balls->x[i] + FIX_FROM_CELL(balls->w) / 2;
+  int spin = half > 0 ? (int)((int64_t)(center - middle) * FIX_ONE / half) : 0;
+  aim_ball(balls, i, spin);
+}
+
+int ball_hit_axes(const BallPool* balls, int i, const Rect* rect) {
+  Rect ball = ball_rect(balls, i);
+  int axes = 0;
+
+  if ((ball.y + ball.h <= rect->y && balls->vy[i] > 0) ||
+      (ball.y >= rect->y + rect->h && balls->vy[i] < 0)) {
+    axes |= BOUNCE_Y;
+  }
+  if ((ball.x + ball.w <= rect->x && balls->vx[i] > 0) ||
+      (ball.x >= rect->x + rect->w && balls->vx[i] < 0)) {
+    axes |= BOUNCE_X;
+  }
+
+  // A ball that ended up inside, e.g. one scattered there, turns around
+  int inside = ball.x < rect->x + rect->w && ball.x + ball.w > rect->x &&
+               ball.y < rect->y + rect->h && ball.y + ball.h > rect->y;
+  if (axes == 0 && inside) {
+    axes = BOUNCE_Y;
+  }
+  return axes;
+}
+
+void bounce_ball(BallPool* balls, int i, int axes) {
+  if (axes & BOUNCE_X) {
+    balls->vx[i] = -balls->vx[i];
+  }
+  if (axes & BOUNCE_Y) {
+    balls->vy[i] = -balls->vy[i];
+  }
+}
+
+void init_packed_bricks(PackedBricks* packed, int cols, int rows,
+                        Arena* arena) {
+  int total = cols * rows;
+
+  // One block for all five arrays
+  int* block = arena_calloc(arena, (size_t)total * 5 + 1, sizeof(int));
+
+  packed->x = block;
+  packed->y = block + total;
+  packed->w = block + total * 2;
+  packed->h = block + total * 3;
+  packed->health = block + total * 4;
+  init_brick_bits(&packed->alive, cols, rows, arena);
+  packed->count = total;
+  packed->live = 0;
+}
+
+void init_brick_bits(BrickBits* bits, int cols, int rows, Arena* arena) {
+  bits->cols = cols;
+  bits->rows = rows;
+  bits->row_words = (cols + 63) / 64;
+  bits->words = arena_calloc(arena, (size_t)bits->row_words * rows + 1,
+                             sizeof(uint64_t));
+}
+
+void copy_brick_bits(BrickBits* to, const BrickBits* from) {
+  memcpy(to->words, from->words,
+         sizeof(uint64_t) * from->row_words * from->rows);
+}
+
+int count_brick_bits(const BrickBits* bits) {
+  int count = 0;
+  int words = bits->row_words * bits->rows;
+  for (int i = 0; i < words; i++) {
+    count += __builtin_popcountll(bits->words[i]);
+  }
+  return count;
+}
+
+void init_bricks(WindowConfig* win_conf, Brick* bricks, PackedBricks* packed,
+                 const Level* level) {
+  int count = level->cols;
+  int rows = level->rows;
+  memset(packed->alive.words, 0,
+         sizeof(uint64_t) * packed->alive.row_words * rows);
+  int brick_char_width = glyph_width(GLYPH_BRICK_STRONG);
+  int total_gap = (count - 1) * BRICK_H_GAP;
+  int usable_width = win_conf->inner_rect.w - total_gap;
+  int brick_width = (usable_width / count) / brick_char_width;
+
+  for (int row = 0; row < rows; row++) {
+    for (int col = 0; col < count; col++) {
+      int index = row * count + col;
+
+      bricks[index].char_width = brick_char_width;
+      bricks[index].rect.w = brick_width * brick_char_width;
+      bricks[index].rect.h = 1;
+      bricks[index].rect.x =
+          win_conf->inner_rect.x +
+          (col * ((brick_width * brick_char_width) + BRICK_H_GAP));
+      bricks[index].rect.y =
+          win_conf->inner_rect.y + row + (BRICK_V_GAP * (row + 1));
+      packed->x[index] = bricks[index].rect.x;
+      packed->y[index] = bricks[index].rect.y;
+      packed->w[index] = bricks[index].rect.w;
+      packed->h[index] = bricks[index].rect.h;
+
+      // Out of range values from a hand edited file count as the nearest
+      // valid one instead of being trusted
+      uint8_t cell = level->cells[index];
+      int health = LEVEL_CELL_HEALTH(cell);
+      if (health > LEVEL_MAX_HEALTH) {
+        health = LEVEL_MAX_HEALTH;
+      }
+      packed->health[index] = health;
+      if (health > 0) {
+        set_brick_bit(&packed->alive, index);
+      }
+
+      // initilizing drop, it only comes to life when the brick breaks
+      int drop = LEVEL_CELL_DROP(cell);
+      bricks[index].drop = health > 0 && drop <= DROP_BOMB ? drop : DROP_NONE;
+    }
+  }
+  packed->live = count_brick_bits(&packed->alive);
+}
+
+void init_drop_pool(DropPool* drops, int capacity, Arena* arena) {
+  drops->items = arena_alloc(arena, sizeof(Drop) * (capacity + 1));
+  drops->count = 0;
+  drops->capacity = capacity;
+}
+
+int spawn_drop(DropPool* drops, Brick* brick, const Rect* rect) {
+  if (brick->drop == DROP_NONE || drops->count == drops->capacity) {
+    return 0;
+  }
+
+  Drop* drop = &drops->items[drops->count++];
+  drop->type = brick->drop;
+  brick->drop = DROP_NONE;
+
+  switch (drop->type) {
+    case DROP_HEALTH:
+      drop->glyph = GLYPH_DROP_HEALTH;
+      break;
+
+      // case DROP_BULLET:
+      //   drop->glyph = GLYPH_DROP_BULLET;
+      //   break;
+
+    case DROP_EXTRA_BALL:
+      drop->glyph = GLYPH_DROP_EXTRA_BALL;
+      break;
+
+    case DROP_BOMB:
+    default:
+      drop->glyph = GLYPH_DROP_BOMB;
+      break;
+  }
+  drop->char_width = glyph_width(drop->glyph);
+
+  drop->rect.w = drop->char_width;
+  drop->rect.h = 1;
+  drop->rect.x = rect->x + (rect->w / 2);
+  drop->rect.y = rect->y + rect->h;
+  return 1;
+}
+
+void init_event_queue(EventQueue* events, int capacity, Arena* arena) {
+  events->items = arena_alloc(arena, sizeof(GameEvent) * (capacity + 1));
+  events->count = 0;
+  events->capacity = capacity;
+  events->dropped = 0;
+}
+
+void push_event(EventQueue* events, GameEventType type, int index, int value) {
+  if (events->count == events->capacity) {
+    events->dropped++;
+    return;
+  }
+
+  events->items[events->count++] = (GameEvent){type, index, value};
+}
+
+void clear_events(EventQueue* events) {
+  events->count = 0;
+  events->dropped = 0;
+}
+
+// Returns the grid cell range [*first, *last] covering the inclusive span
+// [start, start + len], clamped to the grid
+static int cell_span(int start, int len, int cell_len, int cells, int* first,
+                     int* last) {
+  *first = start / cell_len;
+  *last = (start + len) / cell_len;
+
+  if (start + len < 0 || *first >= cells) {
+    return 0;
+  }
+  if (*first < 0) {
+    *first = 0;
+  }
+  if (*last >= cells) {
+    *last = cells - 1;
+  }
+  return 1;
+}
+
+void init_brick_grid(BrickGrid* grid, const WindowConfig* win_conf,
+                     const PackedBricks* packed, Arena* arena) {
+  int total = packed->count;
+
+  // One cell per terminal row and about one brick pitch per cell, so a ball
+  // touches a handful of cells holding one or two bricks each
+  grid->cell_h = 1;
+  grid->cell_w = total > 0 ? packed->w[0] + BRICK_H_GAP : 1;
+  if (grid->cell_w < 1) {
+    grid->cell_w = 1;
+  }
+
+  // Cover the whole window plus the one column / row that is_colliding
+  // still counts as touching on the far edges
+  grid->cols = (win_conf->rect.w + 1) / grid->cell_w + 1;
+  grid->rows = (win_conf->rect.h + 1) / grid->cell_h + 1;
+
+  int cell_count = grid->cols * grid->rows;
+  grid->cell_start = arena_calloc(arena, cell_count + 1, sizeof(int));
+
+  // First pass counts the bricks per cell, second pass fills them in
+  for (int pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      for (int c = 0; c < cell_count; c++) {
+        grid->cell_start[c + 1] += grid->cell_start[c];
+      }
+
+      grid->items =
+          arena_alloc(arena, sizeof(int) * (grid->cell_start[cell_count] + 1));
+    }
+
+    for (int i = 0; i < total; i++) {
+      // Empty cells can never be hit, unless an endless board refills them
+      if (packed->health[i] <= 0 && packed->scroll.height == 0) {
+        continue;
+      }
+
+      int x0, x1, y0, y1;
+      if (!cell_span(packed->x[i], packed->w[i], grid->cell_w, grid->cols, &x0,
+                     &x1) ||
+          !cell_span(packed->y[i], packed->h[i], grid->cell_h, grid->rows, &y0,
+                     &y1)) {
+        continue;
+      }
+
+      for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+          int cell = y * grid->cols + x;
+          if (pass == 0) {
+            grid->cell_start[cell + 1]++;
+          } else {
+            // The cell's start doubles as its write cursor while filling
+            grid->items[grid->cell_start[cell]++] = i;
+          }
+        }
+      }
+    }
+  }
+
+  // The fill pass moved every cursor to the end of its cell, which is where
+  // the next cell starts
+  for (int c = cell_count; c > 0; c--) {
+    grid->cell_start[c] = grid->cell_start[c - 1];
+  }
+  grid->cell_start[0] = 0;
+
+  grid->total = total;
+  init_grid_query(&grid->query, total, arena);
+}
+
+void init_grid_query(GridQuery* query, int total, Arena* arena) {
+  query->candidates = arena_alloc(arena, sizeof(int) * (total + 1));
+  query->seen = arena_calloc(arena, total + 1, sizeof(unsigned));
+  query->stamp = 0;
+  query->total = total;
+}
+
+int query_brick_grid(const BrickGrid* grid, GridQuery* query,
+                     const Rect* rect) {
+  int x0, x1, y0, y1;
+  if (!cell_span(rect->x, rect->w, grid->cell_w, grid->cols, &x0, &x1) ||
+      !cell_span(rect->y, rect->h, grid->cell_h, grid->rows, &y0, &y1)) {
+    return 0;
+  }
+
+  if (++query->stamp == 0) {
+    // The stamp wrapped around, forget every old stamp
+    memset(query->seen, 0, sizeof(unsigned) * query->total);
+    query->stamp = 1;
+  }
+
+  int found = 0;
+  for (int y = y0; y <= y1; y++) {
+    for (int x = x0; x <= x1; x++) {
+      int cell = y * grid->cols + x;
+      for (int k = grid->cell_start[cell]; k < grid->cell_start[cell + 1];
+           k++) {
+        int index = grid->items[k];
+        if (query->seen[index] == query->stamp) {
+          continue;
+        }
+        query->seen[index] = query->stamp;
+
+        // Insertion sort keeps the bricks in the order a full scan would
+        // visit them, the candidate lists are only a few entries long
+        int pos = found++;
+        while (pos > 0 && query->candidates[pos - 1] > index) {
+          query->candidates[pos] = query->candidates[pos - 1];
+          pos--;
+        }
+        query->candidates[pos] = index;
+      }
+    }
+  }
+
+  return found;
+}
+
+int find_ball_hits(const Brick* bricks, const PackedBricks* packed,
+                   const BrickGrid* grid, GridQuery* query,
+                   const BallPool* balls, int i, BrickHit* hits) {
+  const BrickScroll* scroll = &packed->scroll;
+  Rect rect = ball_rect(balls, i);
+  if (scroll->height > 0 && (rect.y > scroll->top + scroll->height ||
+                             rect.y + rect.h < scroll->top)) {
+    return 0;
+  }
+
+  // The grid and the kernel work on where the bricks were laid out, the ball
+  // is moved there along with the bricks around it
+  Rect ring = rect;
+  ring.y += brick_ring_offset(scroll, rect.y);
+  int found = query_brick_grid(grid, query, &ring);
+
+  // Test the candidates 32 at a time with the batch kernel, all with the
+  // velocity the ball arrived with
+  int count = 0;
+  for (int base = 0; base < found; base += 32) {
+    int batch = found - base < 32 ? found - base : 32;
+    uint32_t mask = bricks_hit_mask_indexed(packed, query->candidates + base,
+                                            batch, &ring);
+
+    while (mask && count < MAX_BALL_HITS) {
+      int index = query->candidates[base + __builtin_ctz(mask)];
+      mask &= mask - 1;
+
+      // Near the wrap the moved ball can also meet bricks shown at the other
+      // end of the band, only the ones it really touches count
+      Rect brick = bricks[index].rect;
+      brick.y = brick_screen_y(scroll, brick.y);
+      int axes = is_colliding(&brick, &rect)
+                     ? ball_hit_axes(balls, i, &brick)
+                     : 0;
+      if (axes != 0) {
+        hits[count++] = (BrickHit){index, axes};
+      }
+    }
+  }
+  return count;
+}
+
+void apply_ball_hits(Brick* bricks, PackedBricks* packed, BallPool* balls,
+                     int i, const BrickHit* hits, int count, DropPool* drops,
+                     EventQueue* events) {
+  int* health = packed->health;
+
+  // A brick an earlier ball broke this sub-step no longer counts
+  int bounce = 0;
+  for (int h = 0; h < count; h++) {
+    int index = hits[h].index;
+    if (health[index] <= 0) {
+      continue;
+    }
+
+    bounce |= hits[h].axes;
+    health[index]--;
+    if (health[index] > 0) {
+      push_event(events, EVENT_BRICK_DAMAGED, index, health[index]);
+      continue;
+    }
+
+    clear_brick_bit(&packed->alive, index);
+    packed->live--;
+    push_event(events, EVENT_BRICK_DESTROYED, index, 0);
+    Rect brick = bricks[index].rect;
+    brick.y = brick_screen_y(&packed->scroll, brick.y);
+    if (spawn_drop(drops, &bricks[index], &brick)) {
+      push_event(events, EVENT_DROP_SPAWNED, index,
+                 drops->items[drops->count - 1].type);
+    }
+  }
+  bounce_ball(balls, i, bounce);
+}
+
+void resolve_balls_brick_collision(Brick* bricks, PackedBricks* packed,
+                                   BrickGrid* grid, BallPool* balls,
+                                   DropPool* drops, EventQueue* events) {
+  BrickHit hits[MAX_BALL_HITS];
+  for (int i = 0; i < balls->count; i++) {
+    int count = find_ball_hits(bricks, packed, grid, &grid->query, balls, i,
+                               hits);
+    apply_ball_hits(bricks, packed, balls, i, hits, count, drops, events);
+  }
+}
+
+void update_drops(WindowConfig* win_conf, DropPool* drops, Paddle* paddle,
+                  BallPool* balls, EventQueue* events) {
+  for (int i = 0; i < drops->count; i++) {
+    Drop* drop = &drops->items[i];
+    drop->rect.y++;
+
+    int gone =
+        drop->rect.y >= win_conf->inner_rect.y + win_conf->inner_rect.h;
+    if (!gone && resolve_drop_paddle_collision(drop, paddle, balls)) {
+      push_event(events, EVENT_DROP_CAUGHT, -1, drop->type);
+      gone = 1;
+    }
+
+    if (gone) {
+      // The last drop now sits in slot i and still has to fall this tick
+      drops->items[i] = drops->items[--drops->count];
+      i--;
+    }
+  }
+}
+
+int resolve_drop_paddle_collision(const Drop* drop, Paddle* paddle,
+                                  BallPool* balls) {
+  if (!is_colliding(&drop->rect, &paddle->rect)) {
+    return 0;
+  }
+
+  switch (drop->type) {
+    case DROP_HEALTH:
+      if (paddle->rect.w < MAX_PADDLE_SIZE * paddle->char_width) {
+        paddle->rect.w += 5;
+      }
+      break;
+
+      // case DROP_BULLET:
+      //   break;
+
+    case DROP_EXTRA_BALL:
+      // Nothing happens when the pool is already full
+      add_ball(balls, paddle);
+      break;
+
+    case DROP_BOMB:
+      if (paddle->rect.w > MIN_PADDLE_SIZE * paddle->char_width) {
+        paddle->rect.w -= 5;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  return 1;
+}
+
+int is_colliding(const Rect* a, const Rect* b) {
+  return !(a->x + a->w < b->x ||  // a is left of b
+           a->x > b->x + b->w ||  // a is right of b
+           a->y + a->h < b->y ||  // a is above b
+           a->y > b->y + b->h);   // a is below b
+}
+
+int get_inner_window_width(WindowConfig* win_conf) {
+  return win_conf->rect.w - ((win_conf->padding.x * 2) + 2);
+}
+
+int get_inner_window_height(WindowConfig* win_conf) {
+  return win_conf->rect.h - ((win_conf->padding.y * 2) + 2);
+}
+
+int get_center_offset(int outer_len, int inner_len) {
+  return ((outer_len - inner_len) / 2);
+}
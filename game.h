@@ -0,0 +1,544 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdint.h>
+
+#include "arena.h"
+#include "glyph.h"
+#include "hist.h"
+#include "level.h"
+#include "rng.h"
+#include "validate.h"
+
+#define MIN_PADDLE_SIZE 10
+#define MAX_PADDLE_SIZE 30
+
+// Balls move by fixed point cells with FIX_SHIFT fraction bits, so their
+// speed is not tied to a whole cell per tick
+#define FIX_SHIFT 8
+#define FIX_ONE (1 << FIX_SHIFT)
+#define FIX_FROM_CELL(c) ((c) * FIX_ONE)
+#define FIX_TO_CELL(v) ((v) >> FIX_SHIFT)
+
+// Ball speed in cells per second, whatever the tick rate
+#define DEFAULT_BALL_SPEED 24
+
+// Share of the speed, in percent, that can go sideways at the steepest angle
+#define BALL_MAX_SIDEWAYS 80
+
+// Which way a bounce turns a ball around
+#define BOUNCE_X 1
+#define BOUNCE_Y 2
+
+#define BRICK_COUTN 5
+#define BRICK_ROWS 5
+#define BRICK_H_GAP 1
+#define BRICK_V_GAP 2
+
+// An endless board moves down a row this often
+#define ENDLESS_SCROLL_MS 400
+
+typedef struct {
+  int x;
+  int y;
+} Vec2;
+
+typedef struct {
+  int x;
+  int y;
+  int w;
+  int h;
+} Rect;
+
+typedef struct {
+  Rect rect;
+  Vec2 dir;
+  GlyphId glyph;
+  int char_width;
+} Paddle;
+
+// Fixed-capacity pool of balls kept as parallel arrays, so the passes over
+// the balls read memory linearly. Every array is carved out of the round's
+// arena when the round starts; a lost ball is swap-removed.
+typedef struct {
+  int* x;   // top left corner, fixed point
+  int* y;
+  int* vx;  // velocity, fixed point cells per tick
+  int* vy;
+  unsigned char* launched;
+  int count;
+  int capacity;
+  int speed;  // length of every launched ball's velocity
+
+  // All balls share the same glyph
+  GlyphId glyph;
+  int w;
+  int h;
+} BallPool;
+
+typedef enum {
+  DROP_NONE,
+  DROP_HEALTH,
+  DROP_EXTRA_BALL,
+  DROP_BOMB
+} DropType;
+
+typedef struct {
+  Rect rect;
+  DropType type;
+  GlyphId glyph;
+  int char_width;
+} Drop;
+
+// The drops currently falling. A brick pushes its drop here when it is
+// destroyed and the drop is swap-removed once it is caught or falls out, so
+// the per-tick work follows the live drops rather than the board size. Every
+// brick drops at most once, so a capacity of one per brick never runs out
+// unless an endless board refills its rows faster than drops fall, then the
+// drop is skipped.
+typedef struct {
+  Drop* items;
+  int count;
+  int capacity;
+} DropPool;
+
+typedef struct {
+  Rect rect;
+  DropType drop;  // what the brick releases when destroyed, once
+  int char_width;  // its glyph follows the health, see GLYPH_BRICK_WEAK
+} Brick;
+
+// The brick geometry and health as parallel arrays, the layout the batch
+// collision kernel (collide.h) works on, with the bitboard of the live ones.
+// Brick i here is bricks[i] in the game; the health lives only here.
+// One bit per brick with health left. Every row of the board starts a new
+// run of row_words words, bit c of a row is the brick in column c, so the
+// live bricks of a row are found with count-trailing-zeros and counted with
+// popcount instead of reading every brick.
+typedef struct {
+  uint64_t* words;
+  int cols;
+  int rows;
+  int row_words;
+} BrickBits;
+
+// The rows of the window an endless board turns through. Its bricks keep the
+// place they were laid out at, their ring position, and are hit and drawn
+// shift rows further down, a brick pushed past the bottom of the band comes
+// back in at its top. The band starts and ends on a gap row, so no brick
+// ever sits across the wrap. A height of 0 is a board that does not scroll.
+typedef struct {
+  int top;
+  int height;
+  int shift;  // rows scrolled so far, modulo height
+} BrickScroll;
+
+typedef struct {
+  int* x;  // ring positions, see BrickScroll
+  int* y;
+  int* w;
+  int* h;
+  int* health;
+  BrickBits alive;
+  BrickScroll scroll;
+  int count;
+  int live;  // bricks with health left, kept up to date as they break
+} PackedBricks;
+
+// Returns the window row a brick laid out at row y is on
+static inline int brick_screen_y(const BrickScroll* scroll, int y) {
+  y += scroll->shift;
+  return y >= scroll->top + scroll->height ? y - scroll->height : y;
+}
+
+// Returns what takes window row y, and the rows next to it, to the ring
+// positions of the bricks shown there
+static inline int brick_ring_offset(const BrickScroll* scroll, int y) {
+  return y < scroll->top + scroll->shift ? scroll->height - scroll->shift
+                                         : -scroll->shift;
+}
+
+// Scratch space for a grid query: the candidates found so far and, per brick,
+// the last query that saw it, so a brick spanning several cells is tested
+// once. Threads querying the same grid at once need one each.
+typedef struct {
+  int* candidates;
+  unsigned* seen;
+  unsigned stamp;
+  int total;
+} GridQuery;
+
+// Uniform grid over the window that lists which bricks touch each cell, so a
+// ball only has to be tested against the bricks around it. Cells are stored
+// CSR style: the bricks of cell c are items[cell_start[c] .. cell_start[c+1]).
+typedef struct {
+  int cell_w;
+  int cell_h;
+  int cols;
+  int rows;
+
+  int* cell_start;
+  int* items;
+  int total;
+
+  GridQuery query;  // the serial pass's
+} BrickGrid;
+
+// A brick a ball touched during a sub-step and the axes it turns the ball on
+typedef struct {
+  int index;
+  int axes;
+} BrickHit;
+
+// Most bricks a ball can hit in one sub-step, a ball covers a cell or two and
+// the bricks around it are spaced out, so this is never reached
+#define MAX_BALL_HITS 16
+
+struct StepWorkers;
+
+// Things the simulation reports as they happen, so the scoring and telemetry
+// can follow the changes instead of rescanning the board
+typedef enum {
+  EVENT_BRICK_DAMAGED,
+  EVENT_BRICK_DESTROYED,
+  EVENT_DROP_SPAWNED,
+  EVENT_DROP_CAUGHT,
+  EVENT_BALL_LOST,
+  EVENT_TYPE_COUNT
+} GameEventType;
+
+typedef struct {
+  GameEventType type;
+  int index;  // the brick for brick and spawn events, -1 otherwise
+  int value;  // health left, the drop type, or the balls left for BallLost
+} GameEvent;
+
+#define EVENT_QUEUE_CAPACITY 4096
+
+// Events in the order they happened. They pile up across ticks until the
+// consumer clears the queue, a full queue drops new events and counts them.
+typedef struct {
+  GameEvent* items;
+  int count;
+  int capacity;
+  int dropped;
+} EventQueue;
+
+// Points for the events that score
+#define SCORE_BRICK_DAMAGED 10
+#define SCORE_BRICK_DESTROYED 50
+#define SCORE_DROP_CAUGHT 25
+
+// Represents the window's position, size, and optional padding
+typedef struct {
+  Vec2 padding;
+  Rect rect;
+  Rect inner_rect;
+} WindowConfig;
+
+// Input for a single simulation tick, already decoded from the keyboard
+typedef struct {
+  int paddle_dir;  // -1 left, 1 right, 0 stands still
+  int launch;      // launch every ball still resting on the paddle
+} GameInput;
+
+// Phases of game_step that can be timed
+typedef enum {
+  PHASE_PADDLE,
+  PHASE_BRICKS,
+  PHASE_BOUNDS,
+  PHASE_BALLS,
+  PHASE_DROPS,
+  PHASE_COUNT
+} GamePhase;
+
+// Accumulated time spent in each phase of game_step
+typedef struct {
+  uint64_t ns[PHASE_COUNT];
+  uint64_t ticks;
+
+  // Optional, one histogram per phase that gets the time of every tick
+  LatencyHist* hist;
+} GameProfile;
+
+#define MAX_BALLS 256
+
+// Board layout for a round
+typedef struct {
+  int brick_cols;
+  int brick_rows;
+  int max_balls;
+  int max_events;  // events the queue holds before they are consumed
+
+  // The bricks to play, when NULL a random board of brick_cols x brick_rows
+  const Level* level;
+
+  // Seeds the round's random numbers, the same seed and input replay the
+  // same round
+  uint64_t seed;
+
+  // Ball speed in cells per second and the ticks per second game_step is
+  // called at, together they give the distance a ball covers per tick
+  int ball_speed;
+  int tick_rate;
+
+  // Ticks between two steps of an endless board down a row, see
+  // endless_scroll_period. 0 plays the board once and the round is won when
+  // it is cleared.
+  int scroll_period;
+} GameConfig;
+
+// Everything the simulation needs for one round, free of any ncurses state.
+// All of its memory comes from one arena, so starting a round over only
+// resets the arena.
+typedef struct {
+  Arena arena;
+  WindowConfig win_conf;
+  Paddle paddle;
+  BallPool balls;
+  Brick* bricks;
+  PackedBricks packed;
+  uint8_t* random_cells;  // the random board's cells, NULL with a level
+  int brick_cols;
+  int brick_rows;
+  int brick_total;
+  BrickGrid grid;
+  DropPool drops;
+  EventQueue events;
+  Rng rng;
+  int scroll_period;
+  int scroll_timer;  // ticks since the board last scrolled
+  long score;
+  int game_over;
+  int win;
+
+  // Optional, when set game_step adds its per-phase timings here
+  GameProfile* profile;
+
+  // Optional, when set game_step shares the ball passes out to these threads
+  struct StepWorkers* workers;
+} Game;
+
+// Initialize the window configs for a window of the given size
+void init_win_conf(WindowConfig* win_conf, int width, int height);
+
+// Fills in the default board layout
+void default_game_config(GameConfig* config);
+
+// Returns the scroll_period that moves an endless board at the default pace
+int endless_scroll_period(int tick_rate);
+
+// Returns 1 when the board config describes fits the window in the active
+// glyphs, every brick at least one glyph wide and the last row above where
+// the ball starts. Otherwise prints why not and returns 0, init_game must
+// not be given that board.
+int board_fits(const WindowConfig* win_conf, const GameConfig* config);
+
+// Allocates a game for the given window and board and sets up its first round
+void init_game(Game* game, const WindowConfig* win_conf,
+               const GameConfig* config);
+
+// Starts a new round in place without allocating, config has to describe
+// the same board init_game was given
+void reset_game(Game* game, const GameConfig* config);
+
+// Lays a round out again from scratch in the game's arena, so the window or
+// board may differ from the last one. Once the arena has settled this does
+// not touch the heap.
+void restart_game(Game* game, const WindowConfig* win_conf,
+                  const GameConfig* config);
+
+// Release everything init_game allocated
+void free_game(Game* game);
+
+// Advance the simulation by one tick
+void game_step(Game* game, const GameInput* input);
+
+// Hash of everything a tick can change, two runs that agree on it after every
+// tick played the same game
+uint32_t game_state_hash(const Game* game);
+
+// Returns the display name of a profiled phase
+const char* game_phase_name(GamePhase phase);
+
+void init_event_queue(EventQueue* events, int capacity, Arena* arena);
+
+// Appends an event, or counts it as dropped when the queue is full
+void push_event(EventQueue* events, GameEventType type, int index, int value);
+
+// Forgets the events once they have been consumed
+void clear_events(EventQueue* events);
+
+// Returns the display name of an event type
+const char* game_event_name(GameEventType type);
+
+// Initilize paddle
+void init_paddle(Paddle* paddle, WindowConfig* win_conf);
+
+// Keep the paddle within bounds
+void clamp_paddle_bounds(WindowConfig* win_conf, Paddle* paddle);
+
+// Carves room for capacity balls out of the arena, the pool starts empty
+void init_ball_pool(BallPool* balls, int capacity, Arena* arena);
+
+// Returns the cells covered by ball i
+static inline Rect ball_rect(const BallPool* balls, int i) {
+  return (Rect){FIX_TO_CELL(balls->x[i]), FIX_TO_CELL(balls->y[i]), balls->w,
+                balls->h};
+}
+
+// Initilize ball i resting on the paddle
+void init_ball(BallPool* balls, int i, Paddle* paddle);
+
+// Appends a new ball resting on the paddle and returns its index, or -1 when
+// the pool is full
+int add_ball(BallPool* balls, Paddle* paddle);
+
+// Removes ball i by moving the last ball into its slot
+void remove_ball(BallPool* balls, int i);
+
+// A tick is split into this many sub-steps so no ball moves more than a
+// cell at a time and cannot pass through a brick between two tests
+int ball_substeps(const BallPool* balls);
+
+// Moves ball i through sub-step step of steps, a ball still resting on the
+// paddle has no velocity and stays put
+static inline void move_ball(BallPool* balls, int i, int step, int steps) {
+  // The sub-steps add up to exactly one tick's velocity
+  int vx = balls->vx[i];
+  int vy = balls->vy[i];
+  balls->x[i] += vx * (step + 1) / steps - vx * step / steps;
+  balls->y[i] += vy * (step + 1) / steps - vy * step / steps;
+}
+
+// Moves the launched balls through sub-step step of steps
+void move_balls(BallPool* balls, int step, int steps);
+
+// Bounces the balls off the paddle, keeps resting balls on the paddle and
+// removes the ones that fell out of the window
+void update_balls(WindowConfig* win_conf, BallPool* balls, Paddle* paddle,
+                  EventQueue* events);
+
+void keep_balls_within_bounds(WindowConfig* win_conf, BallPool* balls);
+
+// Returns a launch angle for aim_ball
+int get_random_spin(Rng* rng);
+int get_random_drop(Rng* rng);
+int get_random_health(Rng* rng);
+
+// Sends ball i upwards at full speed, spin runs from -FIX_ONE (steepest to
+// the left) through 0 (straight up) to FIX_ONE
+void aim_ball(BallPool* balls, int i, int spin);
+
+// Sends ball i back up at an angle that follows where it met the paddle
+void deflect_ball(BallPool* balls, int i, const Rect* paddle);
+
+// Returns the BOUNCE_X / BOUNCE_Y axes ball i has to turn around on when it
+// touches rect, 0 when it is already moving away from it
+int ball_hit_axes(const BallPool* balls, int i, const Rect* rect);
+
+void bounce_ball(BallPool* balls, int i, int axes);
+
+// Lays the level's cells out over the window, an empty cell leaves a brick
+// with no health that is never drawn or hit
+void init_bricks(WindowConfig* win_conf, Brick* bricks, PackedBricks* packed,
+                 const Level* level);
+
+// Carves the packed arrays for a board of cols x rows bricks out of the arena
+void init_packed_bricks(PackedBricks* packed, int cols, int rows,
+                        Arena* arena);
+
+// Carves a bitboard for cols x rows bricks out of the arena, all clear
+void init_brick_bits(BrickBits* bits, int cols, int rows, Arena* arena);
+
+// Returns the words of a row of the board
+static inline uint64_t* brick_bits_row(const BrickBits* bits, int row) {
+  return bits->words + (size_t)row * bits->row_words;
+}
+
+static inline int brick_bit(const BrickBits* bits, int i) {
+  int col = i % bits->cols;
+  return (brick_bits_row(bits, i / bits->cols)[col / 64] >> (col % 64)) & 1;
+}
+
+static inline void set_brick_bit(BrickBits* bits, int i) {
+  int col = i % bits->cols;
+  brick_bits_row(bits, i / bits->cols)[col / 64] |= 1ULL << (col % 64);
+}
+
+static inline void clear_brick_bit(BrickBits* bits, int i) {
+  int col = i % bits->cols;
+  brick_bits_row(bits, i / bits->cols)[col / 64] &= ~(1ULL << (col % 64));
+}
+
+// Copies a bitboard of the same size
+void copy_brick_bits(BrickBits* to, const BrickBits* from);
+
+// Returns how many bits are set
+int count_brick_bits(const BrickBits* bits);
+
+// Builds the broadphase grid over the bricks of a window at their ring
+// positions
+void init_brick_grid(BrickGrid* grid, const WindowConfig* win_conf,
+                     const PackedBricks* packed, Arena* arena);
+
+// Carves the scratch space for queries on a grid of total bricks out of the
+// arena
+void init_grid_query(GridQuery* query, int total, Arena* arena);
+
+// Collects the indices of the bricks whose cells the rect touches, in
+// ascending order, and returns how many were found. The result lives in
+// query->candidates until the next query.
+int query_brick_grid(const BrickGrid* grid, GridQuery* query,
+                     const Rect* rect);
+
+void init_drop_pool(DropPool* drops, int capacity, Arena* arena);
+
+// Releases the brick's drop, if it still has one, under rect, where the
+// brick is on screen. Returns 1 when a drop was spawned.
+int spawn_drop(DropPool* drops, Brick* brick, const Rect* rect);
+
+// Moves the live drops down and lets the paddle catch them
+void update_drops(WindowConfig* win_conf, DropPool* drops, Paddle* paddle,
+                  BallPool* balls, EventQueue* events);
+
+// Applies the drop when the paddle touches it, returns 1 if it was caught
+int resolve_drop_paddle_collision(const Drop* drop, Paddle* paddle,
+                                  BallPool* balls);
+
+// Writes the bricks ball i touches to hits, in index order, and returns how
+// many. Health is left to apply_ball_hits, finding only reads the board and
+// the ball, so balls can be looked at in parallel with a query each.
+int find_ball_hits(const Brick* bricks, const PackedBricks* packed,
+                   const BrickGrid* grid, GridQuery* query,
+                   const BallPool* balls, int i, BrickHit* hits);
+
+// Damages the bricks ball i hit that still have health, then turns the ball
+// around once for all of them. Applied in ball order this gives the same
+// game whether the hits were found serially or not.
+void apply_ball_hits(Brick* bricks, PackedBricks* packed, BallPool* balls,
+                     int i, const BrickHit* hits, int count, DropPool* drops,
+                     EventQueue* events);
+
+void resolve_balls_brick_collision(Brick* bricks, PackedBricks* packed,
+                                   BrickGrid* grid, BallPool* balls,
+                                   DropPool* drops, EventQueue* events);
+
+// Returns 1 when no brick has health left
+static inline int all_bricks_destroyed(const PackedBricks* packed) {
+  return packed->live == 0;
+}
+
+// check if a point is coll
+int is_colliding(const Rect* a, const Rect* b);
+
+// Returns the inner width of the window, excluding border and padding
+int get_inner_window_width(WindowConfig* win_conf);
+
+// Returns the inner height of the window, excluding border and padding
+int get_inner_window_height(WindowConfig* win_conf);
+
+// Returns the offset needed to center inner_len within outer_len
+int get_center_offset(int outer_len, int inner_len);
+
+#endif
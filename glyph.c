@@ -0,0 +1,87 @@
+#define _XOPEN_SOURCE 700
+
+#include "glyph.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const wchar_t* const sets[GLYPH_SET_COUNT][GLYPH_COUNT] = {
+    [GLYPH_SET_EMOJI] =
+        {
+            [GLYPH_BLANK] = L" ",
+            [GLYPH_PADDLE] = L"🟪",
+            [GLYPH_BALL] = L"⚽",
+            [GLYPH_BRICK_WEAK] = L"🟨",
+            [GLYPH_BRICK_MEDIUM] = L"🟧",
+            [GLYPH_BRICK_STRONG] = L"🟥",
+            [GLYPH_DROP_HEALTH] = L"♥️",
+            [GLYPH_DROP_EXTRA_BALL] = L"🎁",
+            [GLYPH_DROP_BOMB] = L"💣",
+            [GLYPH_DEBRIS] = L"✦",
+        },
+    [GLYPH_SET_ASCII] =
+        {
+            [GLYPH_BLANK] = L" ",
+            [GLYPH_PADDLE] = L"=",
+            [GLYPH_BALL] = L"o",
+            [GLYPH_BRICK_WEAK] = L"-",
+            [GLYPH_BRICK_MEDIUM] = L"+",
+            [GLYPH_BRICK_STRONG] = L"#",
+            [GLYPH_DROP_HEALTH] = L"H",
+            [GLYPH_DROP_EXTRA_BALL] = L"E",
+            [GLYPH_DROP_BOMB] = L"X",
+            [GLYPH_DEBRIS] = L"*",
+        },
+};
+
+static const char* const set_names[GLYPH_SET_COUNT] = {
+    [GLYPH_SET_EMOJI] = "emoji",
+    [GLYPH_SET_ASCII] = "ascii",
+};
+
+static GlyphTable active;
+static int selected;
+
+void glyphs_select(GlyphSet set) {
+  active.set = set;
+  for (int i = 0; i < GLYPH_COUNT; i++) {
+    active.text[i] = sets[set][i];
+    // The layout has always been measured by the first code point, a
+    // trailing variation selector does not count
+    active.width[i] = wcwidth(sets[set][i][0]);
+  }
+  selected = 1;
+}
+
+const GlyphTable* glyphs_active(void) {
+  if (!selected) {
+    glyphs_select(DEFAULT_GLYPH_SET);
+  }
+  return &active;
+}
+
+int glyph_widths_known(void) {
+  const GlyphTable* table = glyphs_active();
+  for (int i = 0; i < GLYPH_COUNT; i++) {
+    if (table->width[i] <= 0) {
+      fprintf(stderr,
+              "Error: the widths of the %s glyphs are unknown, use a UTF-8 "
+              "locale or --glyphs ascii\n",
+              glyphs_name(table->set));
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int glyphs_parse(const char* name, GlyphSet* set) {
+  for (int i = 0; i < GLYPH_SET_COUNT; i++) {
+    if (strcmp(name, set_names[i]) == 0) {
+      *set = i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+const char* glyphs_name(GlyphSet set) { return set_names[set]; }
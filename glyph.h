@@ -0,0 +1,66 @@
+#ifndef GLYPH_H
+#define GLYPH_H
+
+#include <wchar.h>
+
+// The sets of glyphs the game can be drawn with
+typedef enum {
+  GLYPH_SET_EMOJI,
+  GLYPH_SET_ASCII,
+  GLYPH_SET_COUNT
+} GlyphSet;
+
+#ifdef USE_ASCII
+#define DEFAULT_GLYPH_SET GLYPH_SET_ASCII
+#else
+#define DEFAULT_GLYPH_SET GLYPH_SET_EMOJI
+#endif
+
+// Everything the game draws. The brick glyphs follow each other so a brick's
+// glyph is GLYPH_BRICK_WEAK + health - 1.
+typedef enum {
+  GLYPH_BLANK,
+  GLYPH_PADDLE,
+  GLYPH_BALL,
+  GLYPH_BRICK_WEAK,
+  GLYPH_BRICK_MEDIUM,
+  GLYPH_BRICK_STRONG,
+  GLYPH_DROP_HEALTH,
+  GLYPH_DROP_EXTRA_BALL,
+  GLYPH_DROP_BOMB,
+  GLYPH_DEBRIS,
+  GLYPH_COUNT
+} GlyphId;
+
+// The active set with the display width of every glyph measured once, the
+// board layout and the renderers read it instead of calling wcwidth
+typedef struct {
+  GlyphSet set;
+  const wchar_t* text[GLYPH_COUNT];
+  int width[GLYPH_COUNT];
+} GlyphTable;
+
+// Makes set the active one and measures its glyphs in the current locale, so
+// call it after setlocale. A round laid out before the switch keeps its
+// geometry, the next init_game picks up the new widths.
+void glyphs_select(GlyphSet set);
+
+// Returns the active table, selecting DEFAULT_GLYPH_SET on first use
+const GlyphTable* glyphs_active(void);
+
+// Returns the display width of a glyph in the active set
+static inline int glyph_width(GlyphId id) {
+  return glyphs_active()->width[id];
+}
+
+// Returns 1 when the locale knows the display width of the active glyphs,
+// which the board layout is measured in, otherwise prints why not and
+// returns 0
+int glyph_widths_known(void);
+
+// Parses "emoji" or "ascii", returns 0 for anything else
+int glyphs_parse(const char* name, GlyphSet* set);
+
+const char* glyphs_name(GlyphSet set);
+
+#endif
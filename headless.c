@@ -0,0 +1,188 @@
+#define _XOPEN_SOURCE 700
+
+#include "headless.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "raster.h"
+#include "timing.h"
+#include "workers.h"
+
+// Steers the paddle under the lowest launched ball and launches resting ones,
+// so a headless round keeps going instead of losing the ball right away
+static void autopilot(const Game* game, GameInput* input) {
+  input->paddle_dir = 0;
+  input->launch = 1;
+
+  const BallPool* balls = &game->balls;
+  int target = -1;
+  for (int i = 0; i < balls->count; i++) {
+    if (balls->launched[i] && (target < 0 || balls->y[i] > balls->y[target])) {
+      target = i;
+    }
+  }
+
+  if (target < 0) {
+    return;
+  }
+
+  int paddle_center = game->paddle.rect.x + (game->paddle.rect.w / 2);
+  int ball_x = FIX_TO_CELL(balls->x[target]);
+  if (ball_x < paddle_center) {
+    input->paddle_dir = -1;
+  } else if (ball_x > paddle_center) {
+    input->paddle_dir = 1;
+  }
+}
+
+void scatter_balls(Game* game, int count) {
+  const Rect* inner = &game->win_conf.inner_rect;
+  int top = inner->y;
+  int bottom = game->paddle.rect.y - 1;
+  if (game->brick_total > 0) {
+    top = game->bricks[game->brick_total - 1].rect.y + 2;
+  }
+  if (top >= bottom) {
+    top = inner->y;
+  }
+
+  BallPool* balls = &game->balls;
+  for (int n = 0; n < count; n++) {
+    int i = add_ball(balls, &game->paddle);
+    if (i < 0) {
+      break;
+    }
+
+    balls->launched[i] = 1;
+    int x = inner->x + 1 + rng_below(&game->rng, inner->w - 2);
+    int y = top + rng_below(&game->rng, bottom - top);
+    balls->x[i] = FIX_FROM_CELL(x);
+    balls->y[i] = FIX_FROM_CELL(y);
+    aim_ball(balls, i, get_random_spin(&game->rng));
+    if (rng_below(&game->rng, 2)) {
+      balls->vy[i] = -balls->vy[i];
+    }
+  }
+}
+
+int run_headless(const HeadlessOptions* opts) {
+  if (!glyph_widths_known()) {
+    return 1;
+  }
+
+  WindowConfig win_conf;
+  init_win_conf(&win_conf, opts->width, opts->height);
+
+  // Leave room for the scattered balls on top of the one on the paddle
+  GameConfig config = opts->config;
+  if (config.max_balls < opts->balls + 1) {
+    config.max_balls = opts->balls + 1;
+  }
+  if (!board_fits(&win_conf, &config)) {
+    return 1;
+  }
+
+  GameProfile profile = {0};
+  Game game;
+  init_game(&game, &win_conf, &config);
+  scatter_balls(&game, opts->balls);
+  game.profile = &profile;
+
+  StepWorkers workers;
+  if (opts->threads > 0 &&
+      !step_workers_start(&workers, &game, opts->threads)) {
+    free_game(&game);
+    return 1;
+  }
+
+  uint8_t* cells = NULL;
+  if (opts->raster) {
+    cells = malloc((size_t)raster_cols(&game, 0) * raster_rows(&game, 0));
+    VALIDATE(cells);
+  }
+  uint64_t raster_ns = 0;
+
+  long rounds = 1;
+  long wins = 0;
+  long best_score = 0;
+  long event_counts[EVENT_TYPE_COUNT] = {0};
+  long events_dropped = 0;
+
+  uint64_t start = now_ns();
+  for (long tick = 0; tick < opts->ticks; tick++) {
+    uint64_t allocations = heap_allocations();
+    GameInput input;
+    autopilot(&game, &input);
+    game_step(&game, &input);
+
+    if (cells) {
+      uint64_t raster_start = now_ns();
+      raster_game(&game, cells, 0, 0);
+      raster_ns += now_ns() - raster_start;
+    }
+
+    // Telemetry only needs the tallies, the queue is emptied every tick
+    for (int i = 0; i < game.events.count; i++) {
+      event_counts[game.events.items[i].type]++;
+    }
+    events_dropped += game.events.dropped;
+    clear_events(&game.events);
+
+    if (game.game_over) {
+      wins += game.win;
+      if (game.score > best_score) {
+        best_score = game.score;
+      }
+      config.seed++;
+      reset_game(&game, &config);
+      scatter_balls(&game, opts->balls);
+      rounds++;
+    }
+
+    // Neither the ticks nor the rounds after the first may touch the heap
+    if (tick >= ALLOC_WARMUP_FRAMES) {
+      check_no_allocations(allocations, "tick", tick);
+    }
+  }
+  uint64_t elapsed = now_ns() - start;
+  if (game.score > best_score) {
+    best_score = game.score;
+  }
+  int brick_total = game.brick_total;
+  if (opts->threads > 0) {
+    step_workers_stop(&workers);
+  }
+  free_game(&game);
+  free(cells);
+
+  double seconds = (double)elapsed / NS_PER_SEC;
+  double ticks = profile.ticks ? (double)profile.ticks : 1.0;
+
+  printf("board      %dx%d, %d bricks, %d extra balls\n", opts->width,
+         opts->height, brick_total, opts->balls);
+  if (opts->threads > 0) {
+    printf("threads    %d\n", opts->threads);
+  }
+  printf("ticks      %ld in %.3f s (%ld rounds, %ld won)\n", opts->ticks,
+         seconds, rounds, wins);
+  printf("throughput %.0f ticks/s, %.1f ns/tick\n",
+         seconds > 0 ? opts->ticks / seconds : 0.0, elapsed / ticks);
+  for (int i = 0; i < PHASE_COUNT; i++) {
+    printf("  %-32s %10.1f ns/tick\n", game_phase_name(i),
+           profile.ns[i] / ticks);
+  }
+  if (opts->raster) {
+    printf("raster     %.1f ns/tick\n", raster_ns / ticks);
+  }
+  printf("events     best round score %ld\n", best_score);
+  for (int i = 0; i < EVENT_TYPE_COUNT; i++) {
+    printf("  %-32s %10ld\n", game_event_name(i), event_counts[i]);
+  }
+  if (events_dropped > 0) {
+    printf("  %-32s %10ld\n", "dropped (queue full)", events_dropped);
+  }
+
+  return 0;
+}
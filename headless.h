@@ -0,0 +1,25 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "game.h"
+
+// Options for running the simulation without a terminal
+typedef struct {
+  long ticks;
+  int width;
+  int height;
+  int balls;
+  int raster;  // rasterize the window after every tick, to time it
+  int threads;  // share the ball passes among this many, 0 keeps them serial
+  GameConfig config;
+} HeadlessOptions;
+
+// Adds count launched balls at random spots between the bricks and the
+// paddle, heading in random directions, to stress the simulation
+void scatter_balls(Game* game, int count);
+
+// Runs the simulation for the requested number of ticks with a simple
+// autopilot on the paddle and prints throughput figures to stdout
+int run_headless(const HeadlessOptions* opts);
+
+#endif
@@ -0,0 +1,52 @@
+#include "hist.h"
+
+#include <string.h>
+
+// Returns the largest value that lands in the bucket
+static uint64_t bucket_upper(int index) {
+  if (index < (1 << HIST_SUB_BITS)) {
+    return (uint64_t)index;
+  }
+
+  int shift = index / HIST_HALF - 1;
+  uint64_t lower = (uint64_t)(index - shift * HIST_HALF) << shift;
+  return lower + (1ULL << shift) - 1;
+}
+
+void hist_reset(LatencyHist* hist) { memset(hist, 0, sizeof(*hist)); }
+
+void hist_merge(LatencyHist* hist, const LatencyHist* from) {
+  for (int i = 0; i < HIST_BUCKETS; i++) {
+    hist->counts[i] += from->counts[i];
+  }
+  hist->count += from->count;
+  hist->sum += from->sum;
+  if (from->max > hist->max) {
+    hist->max = from->max;
+  }
+}
+
+uint64_t hist_percentile(const LatencyHist* hist, double fraction) {
+  if (hist->count == 0) {
+    return 0;
+  }
+
+  uint64_t rank = (uint64_t)(fraction * hist->count + 0.5);
+  if (rank < 1) {
+    rank = 1;
+  }
+
+  uint64_t seen = 0;
+  for (int i = 0; i < HIST_BUCKETS; i++) {
+    seen += hist->counts[i];
+    if (seen >= rank) {
+      uint64_t upper = bucket_upper(i);
+      return upper < hist->max ? upper : hist->max;
+    }
+  }
+  return hist->max;
+}
+
+double hist_mean(const LatencyHist* hist) {
+  return hist->count ? (double)hist->sum / hist->count : 0.0;
+}
@@ -0,0 +1,57 @@
+#ifndef HIST_H
+#define HIST_H
+
+#include <stdint.h>
+
+// Log-linear latency histogram in the style of HdrHistogram. Values below
+// 2^HIST_SUB_BITS get a bucket each, above that every power of two is split
+// into 2^(HIST_SUB_BITS - 1) buckets, so a bucket is never wider than about
+// 3% of the values it holds. Recording is a couple of shifts and an
+// increment, cheap enough for every tick.
+#define HIST_SUB_BITS 6
+#define HIST_HALF (1 << (HIST_SUB_BITS - 1))
+// Values are clamped below 2^40, about 18 minutes in ns
+#define HIST_MAX_BITS 40
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 2) * HIST_HALF)
+
+typedef struct {
+  uint32_t counts[HIST_BUCKETS];
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+} LatencyHist;
+
+static inline int hist_bucket(uint64_t value) {
+  if (value < (1ULL << HIST_SUB_BITS)) {
+    return (int)value;
+  }
+  if (value >= (1ULL << HIST_MAX_BITS)) {
+    value = (1ULL << HIST_MAX_BITS) - 1;
+  }
+
+  int shift = 63 - __builtin_clzll(value) - HIST_SUB_BITS + 1;
+  return shift * HIST_HALF + (int)(value >> shift);
+}
+
+static inline void hist_record(LatencyHist* hist, uint64_t value) {
+  hist->counts[hist_bucket(value)]++;
+  hist->count++;
+  hist->sum += value;
+  if (value > hist->max) {
+    hist->max = value;
+  }
+}
+
+void hist_reset(LatencyHist* hist);
+
+// Adds the values recorded in from to hist
+void hist_merge(LatencyHist* hist, const LatencyHist* from);
+
+// Returns the value below which the given fraction (0..1) of the recorded
+// values fall, to the precision of a bucket and never above the maximum
+uint64_t hist_percentile(const LatencyHist* hist, double fraction);
+
+// Returns the average of the recorded values
+double hist_mean(const LatencyHist* hist);
+
+#endif
@@ -0,0 +1,166 @@
+#include "input.h"
+
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "timing.h"
+
+void input_ring_init(InputRing* ring) { memset(ring, 0, sizeof(*ring)); }
+
+// Queues a key read at now
+static void push_key(InputRing* ring, int key, uint64_t now) {
+  // A held key repeats, those presses only extend the event already queued
+  if (ring->tail != ring->head) {
+    InputEvent* last = &ring->items[(ring->tail - 1) % INPUT_RING_SIZE];
+    if (last->key == key) {
+      last->repeats++;
+      last->last_ns = now;
+      ring->merged++;
+      return;
+    }
+  }
+
+  if (ring->tail - ring->head == INPUT_RING_SIZE) {
+    ring->dropped++;
+    return;
+  }
+  ring->items[ring->tail++ % INPUT_RING_SIZE] = (InputEvent){key, 0, now, now};
+}
+
+int input_drain(InputRing* ring, WINDOW* win) {
+  int read = 0;
+  int key;
+  while ((key = wgetch(win)) != ERR) {
+    push_key(ring, key, now_ns());
+    read++;
+  }
+  return read;
+}
+
+// Feeds a byte through the escape sequence decoder, returns 1 and sets *key
+// when it completes a key. Arrows come as ESC [ x or ESC O x, with keypad
+// mode on; other sequences are swallowed whole.
+static int decode_byte(InputRing* ring, unsigned char byte, int* key) {
+  switch (ring->escape) {
+    case 0:
+      if (byte == 27) {
+        ring->escape = 1;
+        return 0;
+      }
+      *key = byte;
+      return 1;
+
+    case 1:
+      if (byte == '[' || byte == 'O') {
+        ring->escape = 2;
+        return 0;
+      }
+      ring->escape = 0;
+      *key = byte;
+      return 1;
+
+    default:
+      // Parameters such as the modifiers in ESC [ 1 ; 5 C come before the
+      // final byte
+      if (byte < 0x40 || byte > 0x7e) {
+        return 0;
+      }
+      ring->escape = 0;
+      switch (byte) {
+        case 'A':
+          *key = KEY_UP;
+          return 1;
+        case 'B':
+          *key = KEY_DOWN;
+          return 1;
+        case 'C':
+          *key = KEY_RIGHT;
+          return 1;
+        case 'D':
+          *key = KEY_LEFT;
+          return 1;
+        default:
+          return 0;
+      }
+  }
+}
+
+int input_read_fd(InputRing* ring, int fd) {
+  int read_keys = 0;
+  struct pollfd pfd = {.fd = fd, .events = POLLIN};
+  while (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) {
+    unsigned char bytes[64];
+    ssize_t got = read(fd, bytes, sizeof(bytes));
+    if (got <= 0) {
+      break;
+    }
+
+    uint64_t now = now_ns();
+    for (ssize_t i = 0; i < got; i++) {
+      int key;
+      if (decode_byte(ring, bytes[i], &key)) {
+        push_key(ring, key, now);
+        read_keys++;
+      }
+    }
+  }
+  return read_keys;
+}
+
+int input_pop(InputRing* ring, InputEvent* event) {
+  if (ring->head == ring->tail) {
+    return 0;
+  }
+  *event = ring->items[ring->head++ % INPUT_RING_SIZE];
+  return 1;
+}
+
+void input_controls_init(InputControls* controls, LatencyHist* latency) {
+  memset(controls, 0, sizeof(*controls));
+  controls->latency = latency;
+}
+
+int input_controls_press(InputControls* controls, const InputEvent* event) {
+  switch (event->key) {
+    case KEY_LEFT:
+    case KEY_RIGHT: {
+      int dir = event->key == KEY_LEFT ? -1 : 1;
+
+      // A press of the key still held is an auto-repeat that only bridges to
+      // the next one, a fresh press or a turn waits out the repeat delay
+      int held = dir == controls->dir && event->time_ns < controls->dir_until;
+      uint64_t until = event->last_ns + (held ? INPUT_REPEAT_HOLD_NS
+                                              : INPUT_PRESS_HOLD_NS);
+      if (!held || until > controls->dir_until) {
+        controls->dir_until = until;
+      }
+      controls->dir = dir;
+      break;
+    }
+    case KEY_UP:
+      controls->launch = 1;
+      break;
+    default:
+      return 0;
+  }
+
+  if (controls->pending_since == 0) {
+    controls->pending_since = event->time_ns;
+  }
+  return 1;
+}
+
+void input_controls_tick(InputControls* controls, uint64_t now,
+                         GameInput* input) {
+  input->paddle_dir = now < controls->dir_until ? controls->dir : 0;
+  input->launch = controls->launch;
+  controls->launch = 0;
+
+  if (controls->pending_since != 0) {
+    if (controls->latency) {
+      hist_record(controls->latency, now - controls->pending_since);
+    }
+    controls->pending_since = 0;
+  }
+}
@@ -0,0 +1,78 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <ncurses.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "hist.h"
+
+// Keys the ring holds between two frames, a power of two
+#define INPUT_RING_SIZE 64
+
+// How long a paddle key keeps the paddle moving. Terminals report presses,
+// not releases: the first press has to outlast the keyboard's repeat delay,
+// after that every auto-repeat only has to bridge the gap to the next one.
+#define INPUT_PRESS_HOLD_NS 300000000ULL
+#define INPUT_REPEAT_HOLD_NS 80000000ULL
+
+// A key read from the terminal. Presses of the same key that follow each
+// other are merged into one event.
+typedef struct {
+  int key;
+  int repeats;       // presses merged into this event after the first
+  uint64_t time_ns;  // when the first of them was read
+  uint64_t last_ns;  // when the last of them was read
+} InputEvent;
+
+// Keys read since the last frame, oldest first. A full ring drops new keys
+// and counts them.
+typedef struct {
+  InputEvent items[INPUT_RING_SIZE];
+  unsigned head;  // next event to pop
+  unsigned tail;  // next free slot
+  int escape;     // how far into an escape sequence input_read_fd is
+  uint64_t dropped;
+  uint64_t merged;
+} InputRing;
+
+// What the game keys ask of the simulation, turned into one GameInput per
+// tick: the paddle moves while its key is held and stops once the presses
+// stop coming, a launch applies to the next tick
+typedef struct {
+  int dir;
+  uint64_t dir_until;
+  int launch;
+
+  // Read time of the oldest key no tick has applied yet, 0 when none
+  uint64_t pending_since;
+
+  // Optional, gets the time from reading a key to the tick that applied it
+  LatencyHist* latency;
+} InputControls;
+
+void input_ring_init(InputRing* ring);
+
+// Reads every key the terminal has pending into the ring without waiting,
+// returns how many were read
+int input_drain(InputRing* ring, WINDOW* win);
+
+// Same as input_drain, but reads the bytes straight from the terminal's fd
+// and decodes the arrow keys itself. ncurses is not thread safe, this is
+// how keys are read while another thread draws through it.
+int input_read_fd(InputRing* ring, int fd);
+
+// Takes the oldest event off the ring, returns 0 when it is empty
+int input_pop(InputRing* ring, InputEvent* event);
+
+void input_controls_init(InputControls* controls, LatencyHist* latency);
+
+// Applies a paddle or launch key, returns 0 for any other key so the caller
+// can handle it
+int input_controls_press(InputControls* controls, const InputEvent* event);
+
+// Fills in the input of the tick that runs at now
+void input_controls_tick(InputControls* controls, uint64_t now,
+                         GameInput* input);
+
+#endif
@@ -0,0 +1,90 @@
+#define _XOPEN_SOURCE 700
+
+#include "level.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int read_u16(const uint8_t* bytes) { return bytes[0] | (bytes[1] << 8); }
+
+int load_level(Level* level, const char* path) {
+  memset(level, 0, sizeof(*level));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Error: cannot open level %s: %s\n", path,
+            strerror(errno));
+    return 0;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < LEVEL_HEADER_SIZE) {
+    fprintf(stderr, "Error: %s is not a compiled level\n", path);
+    close(fd);
+    return 0;
+  }
+
+  size_t size = (size_t)st.st_size;
+  void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "Error: cannot map level %s: %s\n", path, strerror(errno));
+    return 0;
+  }
+
+  // Only the header is checked here, the cells are read once by init_bricks
+  const uint8_t* bytes = map;
+  int cols = read_u16(bytes + 6);
+  int rows = read_u16(bytes + 8);
+  if (memcmp(bytes, LEVEL_MAGIC, 4) != 0 || bytes[4] != LEVEL_VERSION ||
+      cols == 0 || rows == 0 ||
+      size != LEVEL_HEADER_SIZE + (size_t)cols * rows) {
+    fprintf(stderr, "Error: %s is not a compiled level (version %d)\n", path,
+            LEVEL_VERSION);
+    munmap(map, size);
+    return 0;
+  }
+
+  level->cols = cols;
+  level->rows = rows;
+  level->cells = bytes + LEVEL_HEADER_SIZE;
+  level->map = map;
+  level->map_size = size;
+  return 1;
+}
+
+void unload_level(Level* level) {
+  if (level->map) {
+    munmap(level->map, level->map_size);
+  }
+  memset(level, 0, sizeof(*level));
+}
+
+uint32_t level_hash(const Level* level) {
+  uint32_t hash = 2166136261u;
+  size_t count = (size_t)level->cols * level->rows;
+
+  hash = (hash ^ (uint32_t)level->cols) * 16777619u;
+  hash = (hash ^ (uint32_t)level->rows) * 16777619u;
+  for (size_t i = 0; i < count; i++) {
+    hash = (hash ^ level->cells[i]) * 16777619u;
+  }
+  return hash;
+}
+
+int write_level(FILE* out, int cols, int rows, const uint8_t* cells) {
+  uint8_t header[LEVEL_HEADER_SIZE] = {
+      LEVEL_MAGIC[0], LEVEL_MAGIC[1], LEVEL_MAGIC[2], LEVEL_MAGIC[3],
+      LEVEL_VERSION,  0,
+      cols & 0xff,    (cols >> 8) & 0xff,
+      rows & 0xff,    (rows >> 8) & 0xff,
+  };
+
+  size_t count = (size_t)cols * rows;
+  return fwrite(header, 1, sizeof(header), out) == sizeof(header) &&
+         fwrite(cells, 1, count, out) == count;
+}
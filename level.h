@@ -0,0 +1,52 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// A compiled level is a small header followed by one byte per brick, row by
+// row. The low nibble of a cell is the brick's health, 0 leaving the cell
+// empty, and the high nibble is the DropType the brick releases. The file is
+// mapped as is, the game builds its bricks straight from the mapped cells.
+//
+// Header, all fields little-endian:
+//   0  magic "BKLV"
+//   4  version (1 byte)
+//   5  reserved (1 byte, 0)
+//   6  cols (2 bytes)
+//   8  rows (2 bytes)
+#define LEVEL_MAGIC "BKLV"
+#define LEVEL_VERSION 1
+#define LEVEL_HEADER_SIZE 10
+#define LEVEL_MAX_DIM 0xffff
+#define LEVEL_MAX_HEALTH 3
+
+#define LEVEL_CELL(health, drop) ((uint8_t)(((drop) << 4) | (health)))
+#define LEVEL_CELL_HEALTH(cell) ((cell) & 0x0f)
+#define LEVEL_CELL_DROP(cell) ((cell) >> 4)
+
+typedef struct {
+  int cols;
+  int rows;
+  const uint8_t* cells;
+
+  // The mapping behind cells, NULL when the cells were built in memory
+  void* map;
+  size_t map_size;
+} Level;
+
+// Maps a compiled level file. Returns 1 on success, otherwise prints why to
+// stderr and returns 0.
+int load_level(Level* level, const char* path);
+
+// Unmaps a level loaded with load_level
+void unload_level(Level* level);
+
+// FNV-1a hash of the level's size and cells, to tell levels apart
+uint32_t level_hash(const Level* level);
+
+// Writes a level in the compiled format, returns 0 on a write error
+int write_level(FILE* out, int cols, int rows, const uint8_t* cells);
+
+#endif
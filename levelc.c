@@ -0,0 +1,142 @@
+#define _XOPEN_SOURCE 700
+
+// Compiles a text level into the binary format the game maps at startup.
+//
+// Text format: one line per brick row, one token per brick, separated by
+// spaces. Blank lines and lines starting with '#' are skipped.
+//   .      empty cell
+//   1..3   brick health
+//   1..3h  the brick drops a health pickup, 'e' an extra ball, 'b' a bomb
+// Every row needs the same number of tokens.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "level.h"
+
+// Parses one token into a cell, returns 0 if it is malformed
+static int parse_cell(const char* token, uint8_t* cell) {
+  if (strcmp(token, ".") == 0) {
+    *cell = LEVEL_CELL(0, DROP_NONE);
+    return 1;
+  }
+
+  if (token[0] < '1' || token[0] > '0' + LEVEL_MAX_HEALTH) {
+    return 0;
+  }
+  int health = token[0] - '0';
+
+  DropType drop;
+  switch (token[1]) {
+    case '\0':
+      drop = DROP_NONE;
+      break;
+    case 'h':
+      drop = DROP_HEALTH;
+      break;
+    case 'e':
+      drop = DROP_EXTRA_BALL;
+      break;
+    case 'b':
+      drop = DROP_BOMB;
+      break;
+    default:
+      return 0;
+  }
+
+  if (token[1] != '\0' && token[2] != '\0') {
+    return 0;
+  }
+
+  *cell = LEVEL_CELL(health, drop);
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s LEVEL.txt LEVEL.lvl\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  FILE* in = fopen(argv[1], "r");
+  if (in == NULL) {
+    perror(argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  uint8_t* cells = NULL;
+  size_t capacity = 0;
+  size_t count = 0;
+  int cols = 0;
+  int rows = 0;
+
+  char* line = NULL;
+  size_t line_size = 0;
+  int line_no = 0;
+  while (getline(&line, &line_size, in) != -1) {
+    line_no++;
+
+    char* start = line;
+    while (isspace((unsigned char)*start)) {
+      start++;
+    }
+    if (*start == '\0' || *start == '#') {
+      continue;
+    }
+
+    int row_cols = 0;
+    for (char* token = strtok(start, " \t\r\n"); token;
+         token = strtok(NULL, " \t\r\n")) {
+      if (count == capacity) {
+        capacity = capacity ? capacity * 2 : 256;
+        cells = realloc(cells, capacity);
+        if (cells == NULL) {
+          fprintf(stderr, "Error: out of memory\n");
+          return EXIT_FAILURE;
+        }
+      }
+
+      if (!parse_cell(token, &cells[count])) {
+        fprintf(stderr, "%s:%d: bad cell '%s'\n", argv[1], line_no, token);
+        return EXIT_FAILURE;
+      }
+      count++;
+      row_cols++;
+    }
+
+    if (rows == 0) {
+      cols = row_cols;
+    } else if (row_cols != cols) {
+      fprintf(stderr, "%s:%d: row has %d cells, expected %d\n", argv[1],
+              line_no, row_cols, cols);
+      return EXIT_FAILURE;
+    }
+    rows++;
+  }
+  free(line);
+  fclose(in);
+
+  if (rows == 0 || cols > LEVEL_MAX_DIM || rows > LEVEL_MAX_DIM) {
+    fprintf(stderr, "%s: a level needs 1 to %d rows and columns\n", argv[1],
+            LEVEL_MAX_DIM);
+    return EXIT_FAILURE;
+  }
+
+  FILE* out = fopen(argv[2], "wb");
+  if (out == NULL) {
+    perror(argv[2]);
+    return EXIT_FAILURE;
+  }
+  if (!write_level(out, cols, rows, cells) || fclose(out) != 0) {
+    perror(argv[2]);
+    remove(argv[2]);
+    return EXIT_FAILURE;
+  }
+
+  free(cells);
+  printf("%s: %dx%d bricks\n", argv[2], cols, rows);
+  return EXIT_SUCCESS;
+}
@@ -9,103 +9,28 @@
 #include <unistd.h>
 #include <wchar.h>
 
+#include "broadcast.h"
+#include "game.h"
+#include "headless.h"
+#include "input.h"
+#include "present.h"
+#include "render.h"
+#include "replay.h"
+#include "timing.h"
+#include "trace.h"
+
 // Define desired game window dimension
 #define GAME_WIDTH ((COLS % 2 == 0) ? COLS : COLS - 1)
 #define GAME_HEIGHT LINES
 
-#ifdef USE_ASCII
-    #define PADDLE_CHAR L"="
-    #define BALL_CHAR L"o"
-    #define BRICK_STRONG L"#"
-    #define BRICK_MEDIUM L"+"
-    #define BRICK_WEAK L"-"
-    #define DROP_HEALTH_CHAR L"H"
-    #define DROP_EXTRA_BALL_CHAR L"E"
-    #define DROP_BOMB_CHAR L"X"
-#else
-    #define PADDLE_CHAR L"🟪"
-    #define BALL_CHAR L"⚽"
-    #define BRICK_STRONG L"🟥"
-    #define BRICK_MEDIUM L"🟧"
-    #define BRICK_WEAK L"🟨"
-    #define DROP_HEALTH_CHAR L"♥️"
-    #define DROP_EXTRA_BALL_CHAR L"🎁"
-    #define DROP_BOMB_CHAR L"💣"
-#endif
-
-#define MIN_PADDLE_SIZE 10
-#define MAX_PADDLE_SIZE 30
-
 #define COLS_NOBORDER (COLS - 2)
 
-#define BRICK_COUTN 5
-#define BRICK_ROWS 5
-#define BRICK_H_GAP 1
-#define BRICK_V_GAP 2
-
-typedef struct {
-  int x;
-  int y;
-} Vec2;
-
-typedef struct {
-  int x;
-  int y;
-  int w;
-  int h;
-} Rect;
-
-typedef struct {
-  Rect rect;
-  Vec2 dir;
-  wchar_t* ch;
-  int char_width;
-} Paddle;
-
-typedef struct {
-  Rect rect;
-  Vec2 dir;
-  wchar_t* ch;
-  int char_width;
-  int is_launched;
-} Ball;
-
-typedef struct {
-  Ball** items;
-  int count;
-} BallArray;
+// Stops the game until it is pressed again
+#define PAUSE_KEY 'p'
 
-typedef enum {
-  DROP_NONE,
-  DROP_HEALTH,
-  DROP_EXTRA_BALL,
-  DROP_BOMB
-} DropType;
-
-typedef struct {
-  Rect rect;
-  DropType type;
-  wchar_t* ch;
-  int char_width;
-  int spawned;
-  int life;
-  int none;
-} Drop;
-
-typedef struct {
-  Rect rect;
-  Drop drop;
-  wchar_t* ch;
-  int char_width;
-  int health;
-} Brick;
-
-// Represents the window's position, size, and optional padding
-typedef struct {
-  Vec2 padding;
-  Rect rect;
-  Rect inner_rect;
-} WindowConfig;
+// Board size used by --headless when no terminal is attached
+#define HEADLESS_WIDTH 80
+#define HEADLESS_HEIGHT 24
 
 // Initializes ncurses mode and sets up color, input behavior, and cursor
 // visibility
@@ -114,8 +39,6 @@ void init_ncurses();
 // Ends ncurses mode and cleans up any ncurses-specific resources
 void kill_ncurses();
 
-void cleanup(BallArray* balls);
-
 // Checks if terminal size can fit the game window dimensions
 void check_terminal_size();
 
@@ -125,74 +48,144 @@ void setup_background_color();
 // Initialize the game window configs
 void init_game_win_Conf(WindowConfig* win_conf);
 
-// Draws the window frame (border) and applies background color
-void draw_window(WINDOW*);
-
 void draw_start_menu(WINDOW* win);
 void draw_won_menu(WINDOW* win);
 void draw_lost_menu(WINDOW* win);
 
-// Initilize paddle
-void init_paddle(Paddle* paddle, WindowConfig* win_conf);
-
-// Draw the paddle
-void draw_paddle(WINDOW* win, const Paddle* paddle);
-
-// Keep the paddle within bounds
-void clamp_paddle_bounds(WindowConfig* win_conf, Paddle* paddle);
-
-// Initilize ball
-void init_ball(Ball* ball, Paddle* paddle);
-
-// Draw the ball
-void draw_balls(WINDOW* win, WindowConfig* win_conf, BallArray* balls,
-                Paddle* paddle);
-
-void keep_balls_within_bounds(WindowConfig* win_conf, BallArray* balls);
-
-int get_random_direction();
-int get_random_drop();
-int get_random_health();
-
-void bounce_ball(Ball* balls, Rect* rect);
-
-void init_bricks(WindowConfig* win_conf, Brick* bricks, int count);
-
-void draw_bricks(WINDOW* win, Brick* bricks, int count);
-
-void draw_drop(WINDOW* win, WindowConfig* win_conf, Brick* bricks,
-               Paddle* paddle, int count, BallArray* balls);
-
-void resolve_drop_paddle_collision(Drop* drop, Paddle* paddle,
-                                   BallArray* balls);
-
-void resolve_balls_brick_collision(Brick* bricks, int count, BallArray* balls);
-
-// check if a point is coll
-int is_colliding(const Rect* a, const Rect* b);
-
-// Validates a pointer and prints an error message with the pointer's name if
-// it's NULL
-void validate_ptr(void* ptr, const char* name);
+// Settings taken from the command line
+typedef struct {
+  int headless;
+  HeadlessOptions headless_opts;
+  int tick_rate;
+  int endless;
+  int show_stats;
+  const char* level_path;
+  uint64_t seed;
+  const char* record_path;
+  const char* replay_path;
+  int replay_render;
+  const char* broadcast_path;
+  const char* spectate_path;
+  const char* trace_path;
+  RenderBackend renderer;
+  int sync_render;
+  EffectsConfig effects;
+  GlyphSet glyphs;
+} Options;
+
+// Parses the command line, returns 0 on unknown or malformed arguments
+int parse_args(int argc, char** argv, Options* opts);
+
+// Prints the frame scheduler counters collected during the session
+void print_scheduler_stats(const FrameScheduler* sched);
+
+// Captures the game into the presenter's next snapshot, ready to submit
+void fill_snapshot(Presenter* presenter, const Game* game, FrameTrace* trace,
+                   unsigned redraws, int paused);
+
+// Blocks with the tick timer stopped until the pause key comes again,
+// returns 0 then or 1 when the player quit instead
+int wait_paused(FrameScheduler* sched, InputRing* keys);
+
+// Re-simulates a recording as fast as possible, drawing every tick when
+// render is set, and prints the result
+int run_replay(const char* path, int render, RenderBackend renderer,
+               const EffectsConfig* effects, const Level* level);
+
+// Draws the game broadcast into path until it ends or q is pressed
+int run_spectate(const char* path, RenderBackend renderer,
+                 const EffectsConfig* effects);
+
+// Sets up the window and the game settings a recording or a broadcast
+// describes
+void config_from_header(const ReplayHeader* header, const Level* level,
+                        WindowConfig* win_conf, GameConfig* config);
+
+int main(int argc, char** argv) {
+  Options opts = {
+      .headless_opts = {.ticks = 100000,
+                        .width = HEADLESS_WIDTH,
+                        .height = HEADLESS_HEIGHT},
+      .tick_rate = DEFAULT_TICK_RATE,
+      .seed = (uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32),
+      .renderer = DEFAULT_RENDERER,
+      .glyphs = DEFAULT_GLYPH_SET,
+  };
+  default_game_config(&opts.headless_opts.config);
+  default_effects_config(&opts.effects);
+  if (!parse_args(argc, argv, &opts)) {
+    fprintf(stderr,
+            "Usage: %s [--tick-rate HZ] [--ball-speed N] [--stats]\n"
+            "            [--level FILE] [--seed N] [--record FILE]\n"
+            "            [--endless] [--trace FILE.csv|FILE.json]\n"
+            "            [--renderer ncurses|ansi] [--glyphs emoji|ascii]\n"
+            "            [--sync-render] [--particles N]\n"
+            "            [--effects-budget US] [--broadcast FILE]\n"
+            "       %s --headless [--ticks N] [--width W] [--height H]\n"
+            "            [--brick-cols N] [--brick-rows N] [--balls N]\n"
+            "            [--tick-rate HZ] [--ball-speed N] [--level FILE]\n"
+            "            [--seed N] [--glyphs emoji|ascii] [--endless]\n"
+            "            [--raster] [--threads N]\n"
+            "       %s --replay FILE [--render] [--renderer ncurses|ansi]\n"
+            "            [--level FILE] [--particles N] [--effects-budget US]\n"
+            "       %s --spectate FILE [--renderer ncurses|ansi]\n"
+            "            [--particles N] [--effects-budget US]\n",
+            argv[0], argv[0], argv[0], argv[0]);
+    return EXIT_FAILURE;
+  }
 
-// Macro to validate a pointer and print its name if NULL.
-#define VALIDATE(ptr) validate_ptr(ptr, #ptr)
+  // setenv("TERMINFO", "./vendor/ncurses/build/share/terminfo", 1);
+  setlocale(LC_ALL, "");
+  glyphs_select(opts.glyphs);
+  opts.headless_opts.config.seed = opts.seed;
+  opts.headless_opts.config.tick_rate = opts.tick_rate;
+  if (opts.endless) {
+    opts.headless_opts.config.scroll_period =
+        endless_scroll_period(opts.tick_rate);
+  }
 
-// Returns the inner width of the window, excluding border and padding
-int get_inner_window_width(WindowConfig* win_conf);
+  // The level stays mapped for the whole session, every round reads it
+  Level level;
+  if (opts.level_path) {
+    if (!load_level(&level, opts.level_path)) {
+      return EXIT_FAILURE;
+    }
+    opts.headless_opts.config.level = &level;
+  }
 
-// Returns the inner height of the window, excluding border and padding
-int get_inner_window_height(WindowConfig* win_conf);
+  if (opts.spectate_path) {
+    return run_spectate(opts.spectate_path, opts.renderer, &opts.effects);
+  }
 
-// Returns the offset needed to center inner_len within outer_len
-int get_center_offset(int outer_len, int inner_len);
+  if (opts.headless || opts.replay_path) {
+    int status =
+        opts.replay_path
+            ? run_replay(opts.replay_path, opts.replay_render, opts.renderer,
+                         &opts.effects, opts.headless_opts.config.level)
+            : run_headless(&opts.headless_opts);
+    if (opts.level_path) {
+      unload_level(&level);
+    }
+    return status;
+  }
 
-int main() {
-  // setenv("TERMINFO", "./vendor/ncurses/build/share/terminfo", 1);
-  setlocale(LC_ALL, "");
-  srand(time(NULL));
+  GameConfig game_config;
+  default_game_config(&game_config);
+  game_config.level = opts.headless_opts.config.level;
+  game_config.seed = opts.seed;
+  game_config.tick_rate = opts.tick_rate;
+  game_config.ball_speed = opts.headless_opts.config.ball_speed;
+  game_config.scroll_period = opts.headless_opts.config.scroll_period;
+
+  if (!glyph_widths_known()) {
+    if (opts.level_path) {
+      unload_level(&level);
+    }
+    return EXIT_FAILURE;
+  }
 
   init_ncurses();
+  game_on_fatal = kill_ncurses;
   check_terminal_size();
   setup_background_color();
 
@@ -200,154 +193,584 @@ int main() {
   WindowConfig game_win_conf;
   init_game_win_Conf(&game_win_conf);
 
+  // The window follows the terminal, so only now is it known whether the
+  // board fits. The check runs outside curses so its reason stays on screen,
+  // refresh takes the terminal back when it passes.
+  kill_ncurses();
+  if (!board_fits(&game_win_conf, &game_config)) {
+    if (opts.level_path) {
+      unload_level(&level);
+    }
+    return EXIT_FAILURE;
+  }
+  refresh();
+
   // Create a new window for the game with the specified height, width, pos
   WINDOW* game_win = newwin(game_win_conf.rect.h, game_win_conf.rect.w,
                             game_win_conf.rect.y, game_win_conf.rect.x);
   VALIDATE(game_win);
 
+  // The game frames go through the chosen backend, the menus through ncurses
+  Canvas canvas;
+  canvas_init(&canvas, opts.renderer, game_win);
+
   // ── Draw and handle start menu ──
   draw_start_menu(game_win);
-  int menu_choice = 0;
 
   while (1) {
     int ch = wgetch(game_win);
     if (ch == '1') {
-      menu_choice = 1;  // Start game
-      break;
+      break;  // Start game
     } else if (ch == '2' || ch == 'q') {
+      canvas_free(&canvas);
       kill_ncurses();
       return 0;
     }
   }
 
+  // Every tick's input goes to the recording, so the session can be replayed
+  InputRecorder recorder;
+  if (opts.record_path) {
+    ReplayHeader header;
+    replay_header_init(&header, &game_win_conf, &game_config);
+    if (!recorder_open(&recorder, opts.record_path, &header)) {
+      canvas_free(&canvas);
+      kill_ncurses();
+      return EXIT_FAILURE;
+    }
+  }
+
+  Game game;
+  Presenter presenter;
+  FrameScheduler sched;
+  if (!scheduler_init(&sched, opts.tick_rate)) {
+    canvas_free(&canvas);
+    kill_ncurses();
+    return EXIT_FAILURE;
+  }
+
+  // Collects the frame timings over every round of the session
+  FrameTrace trace;
+  trace_init(&trace);
+
+  InputRing keys;
+  InputControls controls;
+  input_ring_init(&keys);
+
+  // The first round allocates the game's arena, the later ones reuse it
+  init_game(&game, &game_win_conf, &game_config);
+
+  // Spectators lay the board out from the same header a recording has
+  Broadcast broadcast;
+  Broadcast* cast = NULL;
+  if (opts.broadcast_path) {
+    ReplayHeader layout;
+    replay_header_init(&layout, &game_win_conf, &game_config);
+    layout.brick_cols = game.brick_cols;
+    layout.brick_rows = game.brick_rows;
+    if (!broadcast_open(&broadcast, opts.broadcast_path, &game, &layout)) {
+      free_game(&game);
+      scheduler_free(&sched);
+      canvas_free(&canvas);
+      kill_ncurses();
+      return EXIT_FAILURE;
+    }
+    cast = &broadcast;
+  }
+
 start_game:;
   // ── Start Game ──
-  Paddle paddle;
-  init_paddle(&paddle, &game_win_conf);
+  trace_attach(&trace, &game);
 
-  BallArray balls;
-  balls.count = 1;
-  balls.items = malloc(sizeof(Ball*) * balls.count);
-  for (int i = 0; i < balls.count; i++) {
-    balls.items[i] = malloc(sizeof(Ball));
+  // Once the render thread runs, only it calls into ncurses and keys are
+  // read from the terminal's fd. Whatever ncurses already buffered from the
+  // menu is taken first.
+  keypad(game_win, 1);
+  input_drain(&keys, stdscr);
+
+  // The frames of the round are drawn on a render thread unless asked not to
+  if (!presenter_start(&presenter, &canvas, &game, &opts.effects,
+                       !opts.sync_render)) {
+    free_game(&game);
+    scheduler_free(&sched);
+    canvas_free(&canvas);
+    kill_ncurses();
+    return EXIT_FAILURE;
   }
 
-  init_ball(balls.items[balls.count - 1], &paddle);
+  // Draw the whole board at the start, later frames only redraw what moved
+  unsigned redraws = 0;
+  fill_snapshot(&presenter, &game, &trace, redraws, 0);
+  presenter_submit(&presenter, NULL);
+  if (cast) {
+    broadcast_publish(cast, &game, 0);
+  }
+  clear_events(&game.events);
+
+  // Keys read on a frame that runs no tick are kept for the next one
+  input_controls_init(&controls, trace_input_hist(&trace));
+  scheduler_resync(&sched);
+
+  int quit = 0;
+  long frame = 0;
+  while (!quit && !game.game_over) {
+    uint64_t allocations = heap_allocations();
+    trace_frame_begin(&trace);
+
+    // Every key that arrived since the last frame, not only the first one
+    input_read_fd(&keys, STDIN_FILENO);
+    InputEvent event;
+    while (input_pop(&keys, &event)) {
+      if (input_controls_press(&controls, &event)) {
+        continue;
+      }
+      if (event.key == 'q') {
+        quit = 1;
+      } else if (event.key == TRACE_OVERLAY_KEY &&
+                 trace_toggle_overlay(&trace)) {
+        redraws++;
+      } else if (event.key == PAUSE_KEY) {
+        // The paused frame carries the notice, the next one takes it away
+        fill_snapshot(&presenter, &game, &trace, redraws, 1);
+        presenter_submit(&presenter, NULL);
+        if (cast) {
+          broadcast_publish(cast, &game, 1);
+        }
+        quit = wait_paused(&sched, &keys);
+        // The paused time belongs to no frame
+        trace_frame_begin(&trace);
+      }
+    }
+    trace_phase(&trace, FRAME_INPUT);
+
+    // Run as many fixed ticks as the elapsed time asks for, the held keys
+    // apply to each of them and a launch to the first
+    int ticks = scheduler_begin_frame(&sched);
+    for (int i = 0; i < ticks && !game.game_over; i++) {
+      GameInput input;
+      input_controls_tick(&controls, now_ns(), &input);
+      game_step(&game, &input);
+      if (opts.record_path) {
+        recorder_tick(&recorder, &input);
+      }
+    }
+    trace_phase(&trace, FRAME_SIMULATE);
 
-  Brick bricks[BRICK_COUTN * BRICK_ROWS] = {0};
-  init_bricks(&game_win_conf, bricks, BRICK_COUTN);
+    // Hand the state to the renderer. The render thread draws it while this
+    // one waits for the next frame, a slow flush only delays the drawing.
+    fill_snapshot(&presenter, &game, &trace, redraws, 0);
+    if (cast) {
+      broadcast_publish(cast, &game, 0);
+    }
+    clear_events(&game.events);
+    trace_phase(&trace, FRAME_PUBLISH);
+    presenter_submit(&presenter, &trace);
+
+    // Sleep until the next frame is due. Keys are read as soon as they come
+    // in, so their timestamps show how long they waited for a tick.
+    SchedWake wake;
+    while ((wake = scheduler_wait(&sched, STDIN_FILENO)) == SCHED_WAKE_INPUT) {
+      input_read_fd(&keys, STDIN_FILENO);
+    }
+    if (wake == SCHED_WAKE_HANGUP) {
+      quit = 1;
+    }
+    trace_phase(&trace, FRAME_WAIT);
+    trace_frame_end(&trace);
 
-  draw_bricks(game_win, bricks, BRICK_COUTN);
+    // A frame loop that allocates grows the process over a long session
+    if (++frame > ALLOC_WARMUP_FRAMES) {
+      check_no_allocations(allocations, "frame", frame);
+    }
+  }
 
-  // Draw the window frame and apply the background color
-  draw_window(game_win);
+  presenter_stop(&presenter, &trace);
+  canvas_handoff(&canvas);
+
+  if (game.win) {
+    draw_won_menu(game_win);
+  } else {
+    draw_lost_menu(game_win);
+  }
 
-  // draw the paddle at the start
-  draw_paddle(game_win, &paddle);
+  // The menu window blocks in wgetch, an idle menu sleeps until a key comes
+  while (1) {
+    int ch = wgetch(game_win);
+    if (ch == '1') {
+      if (opts.record_path) {
+        recorder_end_round(&recorder);
+      }
+      // A new seed per round, a replay derives the same ones from the first
+      game_config.seed++;
+      restart_game(&game, &game_win_conf, &game_config);
+      goto start_game;
+    } else if (ch == '2' || ch == 'q') {
+      break;
+    }
+  }
 
-  // Draw the ball at the start
-  draw_balls(game_win, &game_win_conf, &balls, &paddle);
+  if (cast) {
+    broadcast_close(cast);
+  }
+  free_game(&game);
+  scheduler_free(&sched);
+  canvas_free(&canvas);
+  kill_ncurses();
+  if (opts.level_path) {
+    unload_level(&level);
+  }
 
-  int ch = 0;
-  nodelay(game_win, 1);
-  keypad(game_win, 1);
+  if (opts.record_path && !recorder_close(&recorder)) {
+    fprintf(stderr, "Error: the recording %s is incomplete\n",
+            opts.record_path);
+  }
 
-  int no_balls_left = 0;
-  int all_bricks_destroyed = 0;
-  int game_over = 0;
-  int win = 0;
-
-  while (ch != 'q' && !game_over) {
-    ch = getch();  // Get input (non-blocking)
-
-    switch (ch) {
-      case KEY_LEFT:
-        paddle.dir.x = -1;
-        break;
-      case KEY_RIGHT:
-        paddle.dir.x = 1;
-        break;
-      case KEY_UP:
-
-        for (int i = 0; i < balls.count; i++) {
-          if (balls.items[i]->is_launched == 0) {
-            balls.items[i]->is_launched = 1;
-            balls.items[i]->dir.y = -1;
-            balls.items[i]->dir.x = get_random_direction();
-          }
-        }
-      default:
-        break;
-    }
+  if (opts.trace_path) {
+    trace_write(&trace, opts.trace_path);
+  }
 
-    paddle.rect.x += paddle.dir.x;
-    clamp_paddle_bounds(&game_win_conf, &paddle);
-    resolve_balls_brick_collision(bricks, BRICK_COUTN, &balls);
-    keep_balls_within_bounds(&game_win_conf, &balls);
+  if (opts.show_stats) {
+    printf("seed        %llu\n", (unsigned long long)opts.seed);
+    print_scheduler_stats(&sched);
+  }
 
-    for (int i = 0; i < balls.count; i++) {
-      balls.items[i]->rect.x += balls.items[i]->dir.x;
-      balls.items[i]->rect.y += balls.items[i]->dir.y;
+  return EXIT_SUCCESS;
+}
 
-      if (is_colliding(&balls.items[i]->rect, &paddle.rect)) {
-        bounce_ball(balls.items[i], &paddle.rect);
+int parse_args(int argc, char** argv, Options* opts) {
+  HeadlessOptions* headless_opts = &opts->headless_opts;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--headless") == 0) {
+      opts->headless = 1;
+    } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+      headless_opts->ticks = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+      headless_opts->width = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+      headless_opts->height = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--brick-cols") == 0 && i + 1 < argc) {
+      headless_opts->config.brick_cols = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--brick-rows") == 0 && i + 1 < argc) {
+      headless_opts->config.brick_rows = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--balls") == 0 && i + 1 < argc) {
+      headless_opts->balls = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--raster") == 0) {
+      headless_opts->raster = 1;
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      headless_opts->threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+      opts->tick_rate = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--ball-speed") == 0 && i + 1 < argc) {
+      headless_opts->config.ball_speed = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--endless") == 0) {
+      opts->endless = 1;
+    } else if (strcmp(argv[i], "--stats") == 0) {
+      opts->show_stats = 1;
+    } else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+      opts->level_path = argv[++i];
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      opts->seed = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      opts->record_path = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      opts->replay_path = argv[++i];
+    } else if (strcmp(argv[i], "--broadcast") == 0 && i + 1 < argc) {
+      opts->broadcast_path = argv[++i];
+    } else if (strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+      opts->spectate_path = argv[++i];
+    } else if (strcmp(argv[i], "--render") == 0) {
+      opts->replay_render = 1;
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      opts->trace_path = argv[++i];
+    } else if (strcmp(argv[i], "--renderer") == 0 && i + 1 < argc) {
+      i++;
+      if (strcmp(argv[i], "ncurses") == 0) {
+        opts->renderer = RENDER_NCURSES;
+      } else if (strcmp(argv[i], "ansi") == 0) {
+        opts->renderer = RENDER_ANSI;
+      } else {
+        return 0;
+      }
+    } else if (strcmp(argv[i], "--particles") == 0 && i + 1 < argc) {
+      opts->effects.max_particles = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--effects-budget") == 0 && i + 1 < argc) {
+      opts->effects.budget_ns = strtoull(argv[++i], NULL, 10) * 1000;
+    } else if (strcmp(argv[i], "--sync-render") == 0) {
+      opts->sync_render = 1;
+    } else if (strcmp(argv[i], "--glyphs") == 0 && i + 1 < argc) {
+      if (!glyphs_parse(argv[++i], &opts->glyphs)) {
+        return 0;
       }
+    } else {
+      return 0;
+    }
+  }
+
+  return headless_opts->ticks > 0 && headless_opts->width > 0 &&
+         headless_opts->height > 0 && headless_opts->config.brick_cols > 0 &&
+         headless_opts->config.brick_rows > 0 && headless_opts->balls >= 0 &&
+         headless_opts->threads >= 0 && headless_opts->config.ball_speed > 0 &&
+         headless_opts->config.ball_speed < 65536 && opts->tick_rate > 0 &&
+         opts->tick_rate < 65536 && opts->effects.max_particles >= 0;
+}
+
+int run_replay(const char* path, int render, RenderBackend renderer,
+               const EffectsConfig* effects, const Level* level) {
+  InputPlayer player;
+  if (!player_open(&player, path)) {
+    return EXIT_FAILURE;
+  }
+
+  // The board is laid out in the widths of the glyphs it was played with
+  const ReplayHeader* header = &player.header;
+  glyphs_select(header->glyphs);
+  if (!glyph_widths_known()) {
+    player_close(&player);
+    return EXIT_FAILURE;
+  }
+
+  if (header->level_hash != (level ? level_hash(level) : 0)) {
+    fprintf(stderr,
+            "Error: %s was recorded on another level, pass the same --level "
+            "it was played with\n",
+            path);
+    player_close(&player);
+    return EXIT_FAILURE;
+  }
+
+  WindowConfig win_conf;
+  GameConfig config;
+  config_from_header(header, level, &win_conf, &config);
+  if (!board_fits(&win_conf, &config)) {
+    player_close(&player);
+    return EXIT_FAILURE;
+  }
+
+  Canvas canvas;
+  if (render) {
+    init_ncurses();
+    game_on_fatal = kill_ncurses;
+    if (COLS < header->width || LINES < header->height) {
+      kill_ncurses();
+      fprintf(stderr, "Error: the replay needs a %dx%d terminal\n",
+              header->width, header->height);
+      player_close(&player);
+      return EXIT_FAILURE;
     }
+    setup_background_color();
+    WINDOW* win = newwin(header->height, header->width, 0, 0);
+    VALIDATE(win);
+    canvas_init(&canvas, renderer, win);
+  }
 
-    if (balls.count == 0) {
-      game_over = 1;
-      no_balls_left = 1;
+  // Every tick is drawn in turn, there is nothing to gain from a thread
+  Game game;
+  Presenter presenter;
+  unsigned redraws = 0;
+  init_game(&game, &win_conf, &config);
+  if (render) {
+    presenter_start(&presenter, &canvas, &game, effects, 0);
+  }
+
+  long rounds = 1;
+  long wins = 0;
+  long ticks = 0;
+  uint64_t start = now_ns();
+
+  // No scheduler and no sleeps, every recorded tick runs back to back
+  GameInput input;
+  ReplayStep step;
+  long steps = 0;
+  uint64_t allocations = heap_allocations();
+  while ((step = player_next(&player, &input)) != REPLAY_END) {
+    // Replaying a long session must stay as flat as playing it
+    if (++steps > ALLOC_WARMUP_FRAMES) {
+      check_no_allocations(allocations, "replay step", steps);
+    }
+    allocations = heap_allocations();
+
+    if (step == REPLAY_ROUND_END) {
+      wins += game.win;
+      config.seed++;
+      reset_game(&game, &config);
+      redraws++;
+      rounds++;
+      continue;
     }
 
-    all_bricks_destroyed = 1;
-    for (int i = 0; i < BRICK_COUTN * BRICK_ROWS; i++) {
-      if (bricks[i].health > 0) {
-        all_bricks_destroyed = 0;
-        break;
-      }
+    if (!game.game_over) {
+      game_step(&game, &input);
+      ticks++;
     }
 
-    if (all_bricks_destroyed) {
-      win = 1;
-      game_over = 1;
+    if (render) {
+      fill_snapshot(&presenter, &game, NULL, redraws, 0);
+      presenter_submit(&presenter, NULL);
     }
+    clear_events(&game.events);
+  }
+  uint64_t elapsed = now_ns() - start;
 
-    // Clear
-    wclear(game_win);
-    draw_window(game_win);
-    draw_paddle(game_win, &paddle);
-    draw_balls(game_win, &game_win_conf, &balls, &paddle);
-    draw_bricks(game_win, bricks, BRICK_COUTN);
-    draw_drop(game_win, &game_win_conf, bricks, &paddle, BRICK_COUTN, &balls);
+  if (render) {
+    presenter_stop(&presenter, NULL);
+    canvas_free(&canvas);
+    kill_ncurses();
+  }
+
+  double seconds = (double)elapsed / NS_PER_SEC;
+  printf("replay     %s, seed %llu\n", path,
+         (unsigned long long)header->seed);
+  printf("ticks      %ld in %.3f s (%ld rounds, %ld won)\n", ticks, seconds,
+         rounds, wins + game.win);
+  printf("throughput %.0f ticks/s\n", seconds > 0 ? ticks / seconds : 0.0);
+  printf("final      score %ld, state %08x\n", game.score,
+         game_state_hash(&game));
+
+  free_game(&game);
+  player_close(&player);
+  return EXIT_SUCCESS;
+}
 
-    // Refresh the window to update screen
-    wrefresh(game_win);
+void config_from_header(const ReplayHeader* header, const Level* level,
+                        WindowConfig* win_conf, GameConfig* config) {
+  init_win_conf(win_conf, header->width, header->height);
+
+  default_game_config(config);
+  config->brick_cols = header->brick_cols;
+  config->brick_rows = header->brick_rows;
+  config->max_balls = header->max_balls;
+  config->level = level;
+  config->seed = header->seed;
+  config->tick_rate = header->tick_rate;
+  config->ball_speed = header->ball_speed;
+  config->scroll_period = header->scroll_period;
+}
 
-    napms(1000 / 24);
+int run_spectate(const char* path, RenderBackend renderer,
+                 const EffectsConfig* effects) {
+  Spectator spec;
+  if (!spectator_open(&spec, path)) {
+    return EXIT_FAILURE;
   }
 
-  if (win) {
-    draw_won_menu(game_win);
-  } else {
-    draw_lost_menu(game_win);
+  // The board is laid out in the widths of the glyphs the game uses
+  const ReplayHeader* layout = &spec.header->layout;
+  glyphs_select(layout->glyphs);
+  if (!glyph_widths_known()) {
+    spectator_close(&spec);
+    return EXIT_FAILURE;
   }
 
-  while (1) {
-    int ch = wgetch(game_win);
-    if (ch == '1') {
-      menu_choice = 1;
-      goto start_game;
-    } else if (ch == '2' || ch == 'q') {
-      break;
+  // Only the geometry of the bricks is taken from the layout, their health
+  // comes with the frames
+  WindowConfig win_conf;
+  GameConfig config;
+  config_from_header(layout, NULL, &win_conf, &config);
+  if (!board_fits(&win_conf, &config)) {
+    spectator_close(&spec);
+    return EXIT_FAILURE;
+  }
+
+  init_ncurses();
+  game_on_fatal = kill_ncurses;
+  if (COLS < layout->width || LINES < layout->height) {
+    kill_ncurses();
+    fprintf(stderr, "Error: the broadcast needs a %dx%d terminal\n",
+            layout->width, layout->height);
+    spectator_close(&spec);
+    return EXIT_FAILURE;
+  }
+  setup_background_color();
+  WINDOW* win = newwin(layout->height, layout->width, 0, 0);
+  VALIDATE(win);
+  Canvas canvas;
+  canvas_init(&canvas, renderer, win);
+
+  // Drawn on this thread, which has nothing else to do. The one snapshot
+  // stays with the presenter and every frame read is applied on top of it.
+  Game game;
+  Presenter presenter;
+  init_game(&game, &win_conf, &config);
+  presenter_start(&presenter, &canvas, &game, effects, 0);
+  GameSnapshot* snapshot = presenter_next(&presenter);
+  snapshot_capture(snapshot, &game);
+  snapshot->redraws = 0;
+  snapshot->paused = 0;
+  snapshot->overlay.count = 0;
+
+  // Looks for new frames at the game's tick rate, frames that came in
+  // together are drawn once
+  int tick_rate = layout->tick_rate > 0 ? layout->tick_rate : DEFAULT_TICK_RATE;
+  struct timespec period = {0, NS_PER_SEC / tick_rate};
+  while (spectator_live(&spec) && getch() != 'q') {
+    if (spectator_read(&spec, snapshot)) {
+      presenter_submit(&presenter, NULL);
     }
+    nanosleep(&period, NULL);
   }
+  int ended = !spectator_live(&spec);
 
-  cleanup(&balls);
+  presenter_stop(&presenter, NULL);
+  canvas_free(&canvas);
   kill_ncurses();
 
+  printf("spectated  %s, %llu frames, %llu skipped%s\n", path,
+         (unsigned long long)spec.next, (unsigned long long)spec.skipped,
+         ended ? ", the game ended" : "");
+  free_game(&game);
+  spectator_close(&spec);
   return EXIT_SUCCESS;
 }
 
+void fill_snapshot(Presenter* presenter, const Game* game, FrameTrace* trace,
+                   unsigned redraws, int paused) {
+  GameSnapshot* snapshot = presenter_next(presenter);
+  snapshot_capture(snapshot, game);
+  snapshot->redraws = redraws;
+  snapshot->paused = paused;
+  if (trace) {
+    trace_overlay_text(trace, &snapshot->overlay);
+  } else {
+    snapshot->overlay.count = 0;
+  }
+}
+
+int wait_paused(FrameScheduler* sched, InputRing* keys) {
+  scheduler_pause(sched);
+
+  // No timer is armed, the process sleeps in poll() until a key comes
+  int quit = -1;
+  while (quit < 0) {
+    if (scheduler_wait(sched, STDIN_FILENO) == SCHED_WAKE_HANGUP) {
+      quit = 1;
+      break;
+    }
+
+    input_read_fd(keys, STDIN_FILENO);
+    InputEvent event;
+    while (input_pop(keys, &event)) {
+      if (event.key == PAUSE_KEY) {
+        quit = 0;
+      } else if (event.key == 'q') {
+        quit = 1;
+      }
+    }
+  }
+
+  scheduler_resume(sched);
+  return quit;
+}
+
+void print_scheduler_stats(const FrameScheduler* sched) {
+  printf("tick rate   %llu Hz\n",
+         (unsigned long long)(NS_PER_SEC / sched->tick_ns));
+  printf("frames      %llu\n", (unsigned long long)sched->frames);
+  printf("ticks       %llu\n", (unsigned long long)sched->ticks);
+  printf("late frames %llu\n", (unsigned long long)sched->late_frames);
+  printf("overruns    %llu\n", (unsigned long long)sched->overruns);
+}
+
 void init_ncurses() {
   initscr();
   start_color();
@@ -369,13 +792,6 @@ void kill_ncurses() {
   endwin();  // End ncurses mode
 }
 
-void cleanup(BallArray* balls) {
-  for (int i = 0; i < balls->count; i++) {
-    free(balls->items[i]);
-    balls->items[i] = NULL;
-  }
-}
-
 void check_terminal_size() {
   // Get the current terminal dimensions (height and width)
   int term_height, term_width;
@@ -406,26 +822,10 @@ void setup_background_color() {
 }
 
 void init_game_win_Conf(WindowConfig* win_conf) {
-  win_conf->padding.x = 0;
-  win_conf->padding.y = 0;
-
-  win_conf->rect.w = GAME_WIDTH;
-  win_conf->rect.h = GAME_HEIGHT;
-
-  win_conf->inner_rect.w = get_inner_window_width(win_conf);
-  win_conf->inner_rect.h = get_inner_window_height(win_conf);
+  init_win_conf(win_conf, GAME_WIDTH, GAME_HEIGHT);
 
   win_conf->rect.x = get_center_offset(COLS, win_conf->rect.w);
   win_conf->rect.y = get_center_offset(LINES, win_conf->rect.h);
-
-  win_conf->inner_rect.x = win_conf->padding.x + 1;
-  win_conf->inner_rect.y = win_conf->padding.y + 1;
-}
-
-void draw_window(WINDOW* win) {
-  wbkgd(win, COLOR_PAIR(1));
-  // box(win, 0, 0);
-  wrefresh(win);
 }
 
 void draw_start_menu(WINDOW* win) {
@@ -553,333 +953,3 @@ void draw_lost_menu(WINDOW* win) {
 
   wrefresh(win);
 }
-
-void init_paddle(Paddle* paddle, WindowConfig* win_conf) {
-  paddle->char_width = wcwidth(PADDLE_CHAR[0]);
-  paddle->ch = PADDLE_CHAR;
-
-  // paddle->rect.w = MAX_PADDLE_SIZE * paddle->char_width;
-  paddle->rect.w =
-      ((MAX_PADDLE_SIZE + MIN_PADDLE_SIZE) / 2) * paddle->char_width;
-  paddle->rect.h = 1;
-
-  paddle->rect.x = get_center_offset(win_conf->inner_rect.w, paddle->rect.w);
-  paddle->rect.y = win_conf->inner_rect.h;
-
-  paddle->dir.x = 0;
-  paddle->dir.y = 0;
-}
-
-void draw_paddle(WINDOW* win, const Paddle* paddle) {
-  cchar_t ch;
-  setcchar(&ch, paddle->ch, A_NORMAL, 0, NULL);
-
-  for (int i = 0; i < paddle->rect.w; i += paddle->char_width) {
-    mvwadd_wch(win, paddle->rect.y, paddle->rect.x + i, &ch);
-  }
-  wrefresh(win);
-}
-
-void clamp_paddle_bounds(WindowConfig* win_conf, Paddle* paddle) {
-  if (paddle->rect.x < win_conf->inner_rect.x) {
-    paddle->rect.x = win_conf->inner_rect.x;
-  }
-
-  if (paddle->rect.x + paddle->rect.w > win_conf->inner_rect.w) {
-    paddle->rect.x = win_conf->rect.w - paddle->rect.w - 1;
-  }
-}
-
-void init_ball(Ball* ball, Paddle* paddle) {
-  ball->ch = BALL_CHAR;
-
-  ball->dir.x = 0;
-  ball->dir.y = 0;
-
-  ball->rect.x = paddle->rect.x + (paddle->rect.w / 3);
-  ball->rect.y = paddle->rect.y - 1;
-  ball->rect.w = wcwidth(BALL_CHAR[0]);
-  ball->rect.h = 1;
-
-  ball->is_launched = 0;
-}
-
-void draw_balls(WINDOW* win, WindowConfig* win_conf, BallArray* balls,
-                Paddle* paddle) {
-  for (int i = 0; i < balls->count; i++) {
-    cchar_t ch;
-    setcchar(&ch, balls->items[i]->ch, A_NORMAL, 0, NULL);
-
-    if (balls->items[i]->is_launched == 0) {
-      balls->items[i]->rect.x = paddle->rect.x + (paddle->rect.w / 2) - 1;
-      balls->items[i]->rect.y = paddle->rect.y - 1;
-    }
-
-    if (balls->items[i]->rect.y >= win_conf->inner_rect.h) {
-      free(balls->items[i]);
-      for (int j = i; j < balls->count - 1; j++) {
-        balls->items[j] = balls->items[j + 1];
-      }
-      balls->count--;
-      i--;
-
-      continue;
-    }
-
-    mvwadd_wch(win, balls->items[i]->rect.y, balls->items[i]->rect.x, &ch);
-
-    wrefresh(win);
-  }
-}
-
-void keep_balls_within_bounds(WindowConfig* win_conf, BallArray* balls) {
-  for (int i = 0; i < balls->count; i++) {
-    if (balls->items[i]->rect.x <= win_conf->inner_rect.x ||
-        balls->items[i]->rect.x >= win_conf->inner_rect.w) {
-      balls->items[i]->dir.x *= -1;
-    }
-
-    if (balls->items[i]->rect.y <= win_conf->inner_rect.y ||
-        balls->items[i]->rect.y >= win_conf->inner_rect.h) {
-      balls->items[i]->dir.y *= -1;
-    }
-  }
-}
-
-int get_random_direction() { return (rand() % 3) - 1; }
-
-int get_random_drop() {
-  return (rand() % 4);
-}
-
-int get_random_health() { return (rand() % 3) + 1; }
-
-void bounce_ball(Ball* ball, Rect* rect) {
-  int ball_center = ball->rect.x + (ball->rect.w / 2);
-  int zone_width = rect->w / 3;
-
-  if (ball_center < rect->x + zone_width) {
-    ball->dir.x = -1;
-  } else if (ball_center < rect->x + (2 * zone_width)) {
-    ball->dir.x = 0;
-  } else {
-    ball->dir.x = 1;
-  }
-
-  ball->dir.y *= -1;
-}
-
-void init_bricks(WindowConfig* win_conf, Brick* bricks, int count) {
-  int brick_char_width = wcwidth(BRICK_STRONG[0]);
-  int total_gap = (count - 1) * BRICK_H_GAP;
-  int usable_width = win_conf->inner_rect.w - total_gap;
-  int brick_width = (usable_width / count) / brick_char_width;
-
-  for (int row = 0; row < BRICK_ROWS; row++) {
-    for (int col = 0; col < count; col++) {
-      int index = row * count + col;
-
-      bricks[index].ch = BRICK_STRONG;
-      bricks[index].char_width = wcwidth(BRICK_STRONG[0]);
-      bricks[index].rect.w = brick_width * brick_char_width;
-      bricks[index].rect.h = 1;
-      bricks[index].rect.x =
-          win_conf->inner_rect.x +
-          (col * ((brick_width * brick_char_width) + BRICK_H_GAP));
-      bricks[index].rect.y =
-          win_conf->inner_rect.y + row + (BRICK_V_GAP * (row + 1));
-      bricks[index].health = get_random_health();
-
-      // initilizing drop
-      bricks[index].drop.type = get_random_drop();
-      bricks[index].drop.spawned = 0;
-      bricks[index].drop.life = 1;
-      bricks[index].drop.none = 0;
-      switch (bricks[index].drop.type) {
-        case DROP_HEALTH:
-          bricks[index].drop.ch = DROP_HEALTH_CHAR;
-          bricks[index].drop.char_width = wcwidth(DROP_HEALTH_CHAR[0]);
-          break;
-
-          // case DROP_BULLET:
-          //   bricks[index].drop.ch = DROP_BULLET_CHAR;
-          //   bricks[index].drop.char_width = wcwidth(DROP_BULLET_CHAR[0]);
-          //   break;
-
-        case DROP_EXTRA_BALL:
-          bricks[index].drop.ch = DROP_EXTRA_BALL_CHAR;
-          bricks[index].drop.char_width = wcwidth(DROP_EXTRA_BALL_CHAR[0]);
-          break;
-
-        case DROP_BOMB:
-          bricks[index].drop.ch = DROP_BOMB_CHAR;
-          bricks[index].drop.char_width = wcwidth(DROP_BOMB_CHAR[0]);
-          break;
-
-        case DROP_NONE:
-          bricks[index].drop.none = 1;
-          break;
-      }
-
-      if (!bricks[index].drop.none) {
-        bricks[index].drop.rect.w = bricks[index].drop.char_width;
-        bricks[index].drop.rect.h = 1;
-        bricks[index].drop.rect.x =
-            bricks[index].rect.x + (bricks[index].rect.w / 2);
-        bricks[index].drop.rect.y = bricks[index].rect.y + bricks[index].rect.h;
-      }
-    }
-  }
-}
-
-void resolve_balls_brick_collision(Brick* bricks, int count, BallArray* balls) {
-  for (int i = 0; i < balls->count; i++) {
-    for (int row = 0; row < BRICK_ROWS; row++) {
-      for (int col = 0; col < count; col++) {
-        int index = row * count + col;
-
-        if (is_colliding(&bricks[index].rect, &balls->items[i]->rect)) {
-          if (bricks[index].health != 0) {
-            bounce_ball(balls->items[i], &bricks[index].rect);
-            if (bricks[index].health > 0) {
-              bricks[index].health--;
-            } else {
-              bricks[index].health = 0;
-            }
-          }
-
-          if (bricks[index].health == 0 && bricks[index].drop.spawned == 0 &&
-              bricks[index].drop.life == 1) {
-            bricks[index].drop.spawned = 1;
-          }
-        }
-      }
-    }
-  }
-}
-
-void draw_bricks(WINDOW* win, Brick* bricks, int count) {
-  int total_count = count * BRICK_ROWS;
-  for (int i = 0; i < total_count; i++) {
-    const wchar_t* ch_str;
-    switch (bricks[i].health) {
-      case 3:
-        ch_str = BRICK_STRONG;
-        break;
-      case 2:
-        ch_str = BRICK_MEDIUM;
-        break;
-      case 1:
-        ch_str = BRICK_WEAK;
-        break;
-      case 0:
-        continue;
-    }
-
-    cchar_t ch;
-    setcchar(&ch, ch_str, A_NORMAL, 0, NULL);
-
-    for (int j = 0; j < bricks[i].rect.w; j += bricks[i].char_width) {
-      mvwadd_wch(win, bricks[i].rect.y, bricks[i].rect.x + j, &ch);
-    }
-  }
-  wrefresh(win);
-}
-
-void draw_drop(WINDOW* win, WindowConfig* win_conf, Brick* bricks,
-               Paddle* paddle, int count, BallArray* balls) {
-  int total_count = count * BRICK_ROWS;
-  for (int i = 0; i < total_count; i++) {
-    if (bricks[i].health == 0 && bricks[i].drop.spawned &&
-        !bricks[i].drop.none && bricks[i].drop.life == 1) {
-      cchar_t ch;
-      setcchar(&ch, bricks[i].drop.ch, A_NORMAL, 0, NULL);
-
-      for (int j = 0; j < bricks[i].drop.rect.w;
-           j += bricks[i].drop.char_width) {
-        mvwadd_wch(win, bricks[i].drop.rect.y, bricks[i].drop.rect.x + j, &ch);
-      }
-      bricks[i].drop.rect.y++;
-      if (bricks[i].drop.rect.y >=
-          win_conf->inner_rect.y + win_conf->inner_rect.h) {
-        bricks[i].drop.life = 0;
-      }
-      resolve_drop_paddle_collision(&bricks[i].drop, paddle, balls);
-    }
-  }
-  wrefresh(win);
-}
-
-void resolve_drop_paddle_collision(Drop* drop, Paddle* paddle,
-                                   BallArray* balls) {
-  if (drop->life == 1) {
-    if (is_colliding(&drop->rect, &paddle->rect)) {
-      drop->life = 0;
-      switch (drop->type) {
-        case DROP_HEALTH:
-          if (paddle->rect.w < MAX_PADDLE_SIZE * paddle->char_width) {
-            paddle->rect.w += 5;
-          }
-          break;
-
-          // case DROP_BULLET:
-          //   break;
-
-        case DROP_EXTRA_BALL:
-          balls->items =
-              realloc(balls->items, sizeof(Ball*) * (balls->count + 1));
-          VALIDATE(balls->items);
-
-          balls->items[balls->count] = malloc(sizeof(Ball));
-          VALIDATE(balls->items[balls->count]);
-          init_ball(balls->items[balls->count], paddle);
-
-          balls->count++;
-          break;
-
-        case DROP_BOMB:
-          if (paddle->rect.w > MIN_PADDLE_SIZE * paddle->char_width) {
-            paddle->rect.w -= 5;
-          }
-          break;
-
-        default:
-          break;
-      }
-    }
-  }
-}
-
-int is_colliding(const Rect* a, const Rect* b) {
-  return !(a->x + a->w < b->x ||  // a is left of b
-           a->x > b->x + b->w ||  // a is right of b
-           a->y + a->h < b->y ||  // a is above b
-           a->y > b->y + b->h);   // a is below b
-}
-
-void validate_ptr(void* ptr, const char* name) {
-  // Check if the pointer is NULL
-  if (ptr == NULL) {
-    // End ncurses mode before printing the error message
-    endwin();
-
-    // Print an error message to stderr indicating the pointer is NULL,
-    // including the pointer's name
-    fprintf(stderr, "Error: NULL pointer detected in %s\n", name);
-
-    // Exit the program with failure status (EXIT_FAILURE)
-    exit(EXIT_FAILURE);
-  }
-}
-
-int get_inner_window_width(WindowConfig* win_conf) {
-  return win_conf->rect.w - ((win_conf->padding.x * 2) + 2);
-}
-
-int get_inner_window_height(WindowConfig* win_conf) {
-  return win_conf->rect.h - ((win_conf->padding.y * 2) + 2);
-}
-
-int get_center_offset(int outer_len, int inner_len) {
-  return ((outer_len - inner_len) / 2);
-}
@@ -0,0 +1,127 @@
+#define _XOPEN_SOURCE 700
+
+#include "present.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// Draws a snapshot and flushes it, timing both into trace when it is given
+static void draw_snapshot(Presenter* presenter, GameSnapshot* snapshot,
+                          FrameTrace* trace) {
+  render_frame(presenter->canvas, &presenter->comp, snapshot);
+  if (trace) {
+    trace_phase(trace, FRAME_DRAW);
+  }
+  size_t bytes = present_frame(presenter->canvas);
+  if (trace) {
+    trace_phase(trace, FRAME_FLUSH);
+    if (present_counts_bytes(presenter->canvas)) {
+      trace_bytes(trace, bytes);
+    }
+  }
+}
+
+static void* render_thread(void* arg) {
+  Presenter* presenter = arg;
+  FrameTrace* trace = &presenter->trace;
+
+  // Sleeps until a snapshot is published, wakes that came in while a frame
+  // was drawn add up and are taken in one read
+  while (atomic_load(&presenter->running)) {
+    uint64_t wakes;
+    if (read(presenter->wake_fd, &wakes, sizeof(wakes)) < 0 &&
+        errno != EINTR) {
+      break;
+    }
+
+    GameSnapshot* snapshot = snapshots_acquire(&presenter->buffer);
+    if (snapshot) {
+      trace_phase_begin(trace);
+      trace_append_overlay(trace, &snapshot->overlay);
+      draw_snapshot(presenter, snapshot, trace);
+    }
+  }
+
+  // The last one may have come in during the final frame
+  GameSnapshot* snapshot = snapshots_acquire(&presenter->buffer);
+  if (snapshot) {
+    draw_snapshot(presenter, snapshot, NULL);
+  }
+  return NULL;
+}
+
+int presenter_start(Presenter* presenter, Canvas* canvas, const Game* game,
+                    const EffectsConfig* effects, int threaded) {
+  presenter->canvas = canvas;
+  presenter->threaded = threaded;
+  compositor_init(&presenter->comp, game, effects);
+
+  if (!threaded) {
+    snapshot_init(&presenter->snapshot, game);
+    return 1;
+  }
+
+  presenter->wake_fd = eventfd(0, EFD_CLOEXEC);
+  if (presenter->wake_fd < 0) {
+    fprintf(stderr, "Error: cannot create the render thread's wakeup: %s\n",
+            strerror(errno));
+    compositor_free(&presenter->comp);
+    return 0;
+  }
+
+  snapshots_init(&presenter->buffer, game);
+  trace_init(&presenter->trace);
+  atomic_init(&presenter->running, 1);
+
+  int err = pthread_create(&presenter->thread, NULL, render_thread, presenter);
+  if (err != 0) {
+    fprintf(stderr, "Error: cannot start the render thread: %s\n",
+            strerror(err));
+    snapshots_free(&presenter->buffer);
+    close(presenter->wake_fd);
+    compositor_free(&presenter->comp);
+    return 0;
+  }
+  return 1;
+}
+
+GameSnapshot* presenter_next(Presenter* presenter) {
+  return presenter->threaded ? snapshots_back(&presenter->buffer)
+                             : &presenter->snapshot;
+}
+
+// Bumps the render thread's eventfd, which never blocks the writer
+static void wake_renderer(Presenter* presenter) {
+  uint64_t one = 1;
+  ssize_t written = write(presenter->wake_fd, &one, sizeof(one));
+  (void)written;
+}
+
+void presenter_submit(Presenter* presenter, FrameTrace* trace) {
+  if (!presenter->threaded) {
+    draw_snapshot(presenter, &presenter->snapshot, trace);
+    return;
+  }
+
+  snapshots_publish(&presenter->buffer);
+  wake_renderer(presenter);
+}
+
+void presenter_stop(Presenter* presenter, FrameTrace* trace) {
+  if (presenter->threaded) {
+    atomic_store(&presenter->running, 0);
+    wake_renderer(presenter);
+    pthread_join(presenter->thread, NULL);
+
+    trace_merge(trace, &presenter->trace);
+    snapshots_free(&presenter->buffer);
+    close(presenter->wake_fd);
+  } else {
+    snapshot_free(&presenter->snapshot);
+  }
+  compositor_free(&presenter->comp);
+}
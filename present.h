@@ -0,0 +1,51 @@
+#ifndef PRESENT_H
+#define PRESENT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "render.h"
+#include "snapshot.h"
+#include "trace.h"
+
+// Gets the snapshots of a round onto the terminal. Threaded, a render thread
+// draws the latest published snapshot and flushes it, so a terminal that is
+// slow to take a frame holds up the drawing but never the ticks or the input.
+// During such a round the render thread is the only one that calls into
+// ncurses, which is not thread safe: the caller's thread reads keys from the
+// terminal's fd with input_read_fd, and the menus wait for presenter_stop.
+// Otherwise every snapshot is drawn on the caller's thread as it is
+// submitted.
+typedef struct {
+  Canvas* canvas;
+  Compositor comp;
+  int threaded;
+
+  GameSnapshot snapshot;  // the one snapshot when not threaded
+
+  SnapshotBuffer buffer;
+  pthread_t thread;
+  int wake_fd;  // eventfd bumped after every publish
+  atomic_int running;
+  FrameTrace trace;  // the render thread's draw and flush timings
+} Presenter;
+
+// Prepares to draw the given round into the canvas with the given effects,
+// on a thread of its own when threaded is set. Returns 0 and prints why when
+// that cannot start.
+int presenter_start(Presenter* presenter, Canvas* canvas, const Game* game,
+                    const EffectsConfig* effects, int threaded);
+
+// Returns the snapshot to fill for the next frame
+GameSnapshot* presenter_next(Presenter* presenter);
+
+// Hands over the filled snapshot. Threaded it is published and the call
+// returns at once, otherwise it is drawn and flushed right away, timed into
+// trace unless that is NULL.
+void presenter_submit(Presenter* presenter, FrameTrace* trace);
+
+// Waits for the render thread to draw the last snapshot and exit, and adds
+// its timings to trace
+void presenter_stop(Presenter* presenter, FrameTrace* trace);
+
+#endif
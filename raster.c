@@ -0,0 +1,87 @@
+#include "raster.h"
+
+#include <string.h>
+
+typedef struct {
+  uint8_t* cells;
+  int cols;
+  int shift_x;
+  int shift_y;
+  int width;  // the window, in its own cells
+  int height;
+} Raster;
+
+// Raises the raster cells under a rect of the window to code, the parts
+// outside the window are dropped. With overwrite set the cells are known to
+// hold nothing higher and are simply filled.
+static void raise_rect(const Raster* raster, int x, int y, int w, int h,
+                       uint8_t code, int overwrite) {
+  int x0 = x > 0 ? x : 0;
+  int y0 = y > 0 ? y : 0;
+  int x1 = x + w < raster->width ? x + w : raster->width;
+  int y1 = y + h < raster->height ? y + h : raster->height;
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+
+  x0 >>= raster->shift_x;
+  x1 = (x1 - 1) >> raster->shift_x;
+  y0 >>= raster->shift_y;
+  y1 = (y1 - 1) >> raster->shift_y;
+  for (int row = y0; row <= y1; row++) {
+    uint8_t* line = raster->cells + (size_t)row * raster->cols;
+    if (overwrite) {
+      memset(line + x0, code, x1 - x0 + 1);
+      continue;
+    }
+    for (int col = x0; col <= x1; col++) {
+      if (line[col] < code) {
+        line[col] = code;
+      }
+    }
+  }
+}
+
+void raster_game(const Game* game, uint8_t* cells, int shift_x, int shift_y) {
+  Raster raster = {cells, raster_cols(game, shift_x), shift_x, shift_y,
+                   game->win_conf.rect.w, game->win_conf.rect.h};
+  memset(cells, RASTER_EMPTY,
+         (size_t)raster.cols * raster_rows(game, shift_y));
+
+  // Only the live bricks, straight from the bitboard. They come first and do
+  // not overlap, so at full size they are written without comparing.
+  int overwrite = shift_x == 0 && shift_y == 0;
+  const PackedBricks* packed = &game->packed;
+  const BrickBits* alive = &packed->alive;
+  for (int row = 0; row < alive->rows; row++) {
+    const uint64_t* words = brick_bits_row(alive, row);
+    for (int w = 0; w < alive->row_words; w++) {
+      for (uint64_t bits = words[w]; bits; bits &= bits - 1) {
+        int i = row * alive->cols + w * 64 + __builtin_ctzll(bits);
+        int health = packed->health[i];
+        if (health > LEVEL_MAX_HEALTH) {
+          health = LEVEL_MAX_HEALTH;
+        }
+        raise_rect(&raster, packed->x[i],
+                   brick_screen_y(&packed->scroll, packed->y[i]), packed->w[i],
+                   packed->h[i], RASTER_BRICK_WEAK + health - 1, overwrite);
+      }
+    }
+  }
+
+  for (int i = 0; i < game->drops.count; i++) {
+    const Drop* drop = &game->drops.items[i];
+    raise_rect(&raster, drop->rect.x, drop->rect.y, drop->rect.w, drop->rect.h,
+               RASTER_DROP_HEALTH + drop->type - DROP_HEALTH, 0);
+  }
+
+  const Rect* paddle = &game->paddle.rect;
+  raise_rect(&raster, paddle->x, paddle->y, paddle->w, paddle->h,
+             RASTER_PADDLE, 0);
+
+  const BallPool* balls = &game->balls;
+  for (int i = 0; i < balls->count; i++) {
+    Rect rect = ball_rect(balls, i);
+    raise_rect(&raster, rect.x, rect.y, rect.w, rect.h, RASTER_BALL, 0);
+  }
+}
@@ -0,0 +1,41 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdint.h>
+
+#include "game.h"
+
+// What a cell of a raster holds. The codes are ordered by importance: a
+// downsampled cell covering several things keeps the highest code, so a
+// ball is never hidden behind the brick it touches.
+typedef enum {
+  RASTER_EMPTY,
+  RASTER_BRICK_WEAK,  // followed by the other healths, like the glyphs
+  RASTER_BRICK_MEDIUM,
+  RASTER_BRICK_STRONG,
+  RASTER_DROP_HEALTH,  // followed by the other drop types
+  RASTER_DROP_EXTRA_BALL,
+  RASTER_DROP_BOMB,
+  RASTER_PADDLE,
+  RASTER_BALL,
+  RASTER_CODE_COUNT
+} RasterCode;
+
+// Returns the columns and rows of a raster of the game's window that takes
+// 1 << shift window cells to a raster cell along that axis
+static inline int raster_cols(const Game* game, int shift_x) {
+  return (game->win_conf.rect.w + (1 << shift_x) - 1) >> shift_x;
+}
+
+static inline int raster_rows(const Game* game, int shift_y) {
+  return (game->win_conf.rect.h + (1 << shift_y) - 1) >> shift_y;
+}
+
+// Writes the game as the screen would show it into cells, one RasterCode
+// byte per cell, row major, raster_cols x raster_rows of them. Shifts above
+// 0 downsample: each cell covers a block of the window and holds the highest
+// code in it, e.g. shift_x 1 with shift_y 0 makes the cells about square.
+// Only writes into cells, fast enough to call after every tick.
+void raster_game(const Game* game, uint8_t* cells, int shift_x, int shift_y);
+
+#endif
@@ -0,0 +1,442 @@
+#define _XOPEN_SOURCE_EXTENDED 1
+#define _XOPEN_SOURCE 700
+
+#include "render.h"
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "timing.h"
+
+void canvas_init(Canvas* canvas, RenderBackend backend, WINDOW* win) {
+  memset(canvas, 0, sizeof(*canvas));
+  canvas->backend = backend;
+  canvas->win = win;
+  canvas_load_glyphs(canvas);
+
+  if (backend == RENDER_ANSI) {
+    int x, y, w, h;
+    getbegyx(win, y, x);
+    getmaxyx(win, h, w);
+    ansi_init(&canvas->ansi, STDOUT_FILENO, x, y, w, h);
+  } else {
+    canvas->run_capacity = getmaxx(win);
+    canvas->run = malloc(sizeof(cchar_t) * (canvas->run_capacity + 1));
+    VALIDATE(canvas->run);
+  }
+}
+
+void canvas_load_glyphs(Canvas* canvas) {
+  canvas->glyphs = *glyphs_active();
+  for (int i = 0; i < GLYPH_COUNT; i++) {
+    setcchar(&canvas->cells[i], canvas->glyphs.text[i], A_NORMAL, 0, NULL);
+  }
+  canvas->run_len = 0;
+}
+
+void canvas_free(Canvas* canvas) {
+  if (canvas->backend == RENDER_ANSI) {
+    ansi_free(&canvas->ansi);
+  }
+  free(canvas->run);
+  canvas->run = NULL;
+}
+
+void canvas_handoff(Canvas* canvas) {
+  if (canvas->backend == RENDER_ANSI) {
+    // ncurses no longer knows what is on screen, nor do we once it drew
+    clearok(curscr, TRUE);
+    ansi_invalidate(&canvas->ansi);
+  }
+}
+
+int canvas_width(const Canvas* canvas) { return getmaxx(canvas->win); }
+
+void canvas_clear(Canvas* canvas) {
+  if (canvas->backend == RENDER_ANSI) {
+    ansi_clear(&canvas->ansi);
+  } else {
+    werase(canvas->win);
+  }
+}
+
+void canvas_put(Canvas* canvas, int y, int x, GlyphId glyph) {
+  if (canvas->backend == RENDER_ANSI) {
+    ansi_put(&canvas->ansi, y, x, canvas->glyphs.text[glyph],
+             canvas->glyphs.width[glyph]);
+  } else {
+    mvwadd_wch(canvas->win, y, x, &canvas->cells[glyph]);
+  }
+}
+
+void canvas_put_run(Canvas* canvas, int y, int x, GlyphId glyph, int count) {
+  if (canvas->backend == RENDER_ANSI) {
+    // The ANSI screen is plain memory, a cell at a time costs nothing more
+    const wchar_t* text = canvas->glyphs.text[glyph];
+    int width = canvas->glyphs.width[glyph];
+    for (int i = 0; i < count; i++) {
+      ansi_put(&canvas->ansi, y, x + i * width, text, width);
+    }
+    return;
+  }
+
+  if (count > canvas->run_capacity) {
+    count = canvas->run_capacity;
+  }
+  if (glyph != canvas->run_glyph) {
+    canvas->run_glyph = glyph;
+    canvas->run_len = 0;
+  }
+  for (; canvas->run_len < count; canvas->run_len++) {
+    canvas->run[canvas->run_len] = canvas->cells[glyph];
+  }
+
+  // Wide glyphs take their two columns, the row is cut at the window edge.
+  // The cursor is left after the run like wadd_wch does, so the terminal
+  // cursor does not have to be sent back to its start.
+  mvwadd_wchnstr(canvas->win, y, x, canvas->run, count);
+  wmove(canvas->win, y, x + count * canvas->glyphs.width[glyph]);
+}
+
+void canvas_text(Canvas* canvas, int y, int x, const char* text) {
+  if (canvas->backend == RENDER_ANSI) {
+    ansi_text(&canvas->ansi, y, x, text);
+  } else {
+    mvwaddstr(canvas->win, y, x, text);
+  }
+}
+
+void compositor_init(Compositor* comp, const Game* game,
+                     const EffectsConfig* effects) {
+  memset(comp, 0, sizeof(*comp));
+
+  size_t balls = game->balls.capacity + 1;
+  size_t drops = game->drops.capacity + 1;
+  size_t bricks = game->brick_total + 1;
+  size_t particles =
+      (effects->max_particles > 0 ? effects->max_particles : 0) + 1;
+  arena_init(&comp->arena, (balls + drops) * sizeof(Rect) +
+                               bricks * (sizeof(int) + sizeof(uint64_t)) +
+                               particles * (sizeof(int) * 5 + 3) +
+                               12 * alignof(max_align_t));
+  comp->balls = arena_alloc(&comp->arena, sizeof(Rect) * balls);
+  comp->drops = arena_alloc(&comp->arena, sizeof(Rect) * drops);
+  comp->health = arena_alloc(&comp->arena, sizeof(int) * bricks);
+  init_brick_bits(&comp->alive, game->brick_cols, game->brick_rows,
+                  &comp->arena);
+  comp->brick_total = game->brick_total;
+  effects_init(&comp->effects, effects, &game->win_conf.inner_rect,
+               &comp->arena);
+  comp->score = -1;
+  comp->full_redraw = 1;
+}
+
+void compositor_free(Compositor* comp) {
+  arena_free(&comp->arena);
+  memset(comp, 0, sizeof(*comp));
+}
+
+void compositor_invalidate(Compositor* comp) { comp->full_redraw = 1; }
+
+// Redraws the live bricks that an erased rect may have cut into. A row of
+// bricks shares its height, only the rows the rect reaches are looked at.
+static void repair_bricks(Canvas* canvas, const GameSnapshot* snapshot,
+                          const Rect* erased) {
+  const BrickBits* alive = &snapshot->alive;
+  for (int row = 0; row < alive->rows; row++) {
+    const Rect* first = &snapshot->bricks[row * alive->cols].rect;
+    int y = brick_screen_y(&snapshot->scroll, first->y);
+    if (y + first->h < erased->y || y > erased->y + erased->h) {
+      continue;
+    }
+
+    const uint64_t* words = brick_bits_row(alive, row);
+    for (int w = 0; w < alive->row_words; w++) {
+      for (uint64_t bits = words[w]; bits; bits &= bits - 1) {
+        int i = row * alive->cols + w * 64 + __builtin_ctzll(bits);
+        Rect rect = snapshot->bricks[i].rect;
+        rect.y = y;
+        if (is_colliding(&rect, erased)) {
+          draw_brick(canvas, &snapshot->bricks[i], y, snapshot->health[i]);
+        }
+      }
+    }
+  }
+}
+
+void render_frame(Canvas* canvas, Compositor* comp,
+                  const GameSnapshot* snapshot) {
+  const Brick* bricks = snapshot->bricks;
+  const int* health = snapshot->health;
+
+  const BrickScroll* scroll = &snapshot->scroll;
+  EffectPool* effects = &comp->effects;
+  uint64_t effects_ns = 0;
+
+  // Taking the pause notice away needs the cells under it, and every brick
+  // moves when an endless board scrolls
+  if (comp->full_redraw || snapshot->redraws != comp->redraws ||
+      (comp->paused && !snapshot->paused) || scroll->shift != comp->shift) {
+    canvas_clear(canvas);
+    draw_window(canvas);
+    draw_bricks(canvas, bricks, health, &snapshot->alive, scroll);
+    memcpy(comp->health, health, sizeof(int) * snapshot->brick_total);
+    comp->score = -1;
+  } else {
+    // Take the moving objects off their old spots first
+    erase_rect(canvas, &comp->paddle);
+    for (int i = 0; i < comp->ball_count; i++) {
+      erase_rect(canvas, &comp->balls[i]);
+    }
+    for (int i = 0; i < comp->drop_count; i++) {
+      erase_rect(canvas, &comp->drops[i]);
+    }
+
+    uint64_t start = effects->count > 0 ? now_ns() : 0;
+    for (int i = 0; i < effects->count; i++) {
+      Rect rect = particle_rect(effects, i);
+      erase_rect(canvas, &rect);
+      repair_bricks(canvas, snapshot, &rect);
+    }
+    if (effects->count > 0) {
+      effects_ns += now_ns() - start;
+    }
+
+    // Only the bricks that were hit since the last frame changed, and a
+    // brick only comes back when the board scrolls, so the ones on screen
+    // are all there is to check
+    const BrickBits* on_screen = &comp->alive;
+    int words = on_screen->row_words * on_screen->rows;
+    for (int w = 0; w < words; w++) {
+      for (uint64_t bits = on_screen->words[w]; bits; bits &= bits - 1) {
+        int i = (w / on_screen->row_words) * on_screen->cols +
+                (w % on_screen->row_words) * 64 + __builtin_ctzll(bits);
+        if (health[i] == comp->health[i]) {
+          continue;
+        }
+        Rect rect = bricks[i].rect;
+        rect.y = brick_screen_y(scroll, rect.y);
+        if (health[i] > 0) {
+          draw_brick(canvas, &bricks[i], rect.y, health[i]);
+        } else {
+          erase_rect(canvas, &rect);
+          effects_brick_broken(effects, &rect, SCORE_BRICK_DESTROYED);
+        }
+        comp->health[i] = health[i];
+      }
+    }
+
+    // Objects only overlap bricks at their edges, but a blank left behind
+    // there would punch a hole into the brick until it changes again
+    for (int i = 0; i < comp->ball_count; i++) {
+      repair_bricks(canvas, snapshot, &comp->balls[i]);
+    }
+    for (int i = 0; i < comp->drop_count; i++) {
+      repair_bricks(canvas, snapshot, &comp->drops[i]);
+    }
+  }
+
+  if (snapshot->score != comp->score) {
+    draw_score(canvas, snapshot->score);
+    comp->score = snapshot->score;
+  }
+
+  draw_drop(canvas, &snapshot->drops);
+
+  // The pause holds the particles where they are. Every frame is accounted,
+  // also the ones without particles, so a rate cut by a costly frame grows
+  // back once the particles are gone.
+  if (effects->count > 0) {
+    uint64_t start = now_ns();
+    if (!snapshot->paused) {
+      effects_update(effects);
+    }
+    draw_effects(canvas, effects);
+    effects_ns += now_ns() - start;
+  }
+  if (effects->capacity > 0) {
+    effects_account(effects, effects_ns);
+  }
+
+  draw_balls(canvas, &snapshot->balls);
+  draw_paddle(canvas, &snapshot->paddle);
+
+  if (snapshot->paused) {
+    draw_paused(canvas);
+  }
+  draw_text_box(canvas, &snapshot->overlay);
+
+  // Remember what is on screen now for the next frame
+  comp->paddle = snapshot->paddle.rect;
+  copy_brick_bits(&comp->alive, &snapshot->alive);
+
+  const BallPool* balls = &snapshot->balls;
+  comp->ball_count = balls->count;
+  for (int i = 0; i < balls->count; i++) {
+    comp->balls[i] = ball_rect(balls, i);
+  }
+
+  const DropPool* drops = &snapshot->drops;
+  comp->drop_count = drops->count;
+  for (int i = 0; i < drops->count; i++) {
+    comp->drops[i] = drops->items[i].rect;
+  }
+
+  comp->redraws = snapshot->redraws;
+  comp->shift = scroll->shift;
+  comp->paused = snapshot->paused;
+  comp->full_redraw = 0;
+}
+
+#ifdef TRACE_TERMINAL_BYTES
+
+// glibc's own write, the wrapper below takes the public name
+ssize_t __write(int fd, const void* buf, size_t size);
+
+// Bytes written by this thread while it sits in present_frame, NULL
+// elsewhere
+static _Thread_local size_t* frame_bytes;
+
+// ncurses sends a frame with write() from inside doupdate and has no hook
+// for its output, so this opt-in build replaces write() for the whole
+// process to see how much of it there was. It only works against glibc.
+ssize_t write(int fd, const void* buf, size_t size) {
+  ssize_t written = __write(fd, buf, size);
+  if (frame_bytes && written > 0) {
+    *frame_bytes += written;
+  }
+  return written;
+}
+
+#endif
+
+size_t present_frame(Canvas* canvas) {
+  // Single commit for the whole frame
+  if (canvas->backend == RENDER_ANSI) {
+    return ansi_present(&canvas->ansi);
+  }
+
+  size_t bytes = 0;
+#ifdef TRACE_TERMINAL_BYTES
+  frame_bytes = &bytes;
+#endif
+  wnoutrefresh(canvas->win);
+  doupdate();
+#ifdef TRACE_TERMINAL_BYTES
+  frame_bytes = NULL;
+#endif
+  return bytes;
+}
+
+int present_counts_bytes(const Canvas* canvas) {
+#ifdef TRACE_TERMINAL_BYTES
+  (void)canvas;
+  return 1;
+#else
+  return canvas->backend == RENDER_ANSI;
+#endif
+}
+
+void draw_window(Canvas* canvas) {
+  // The ANSI backend sets the same colors with every frame it sends
+  if (canvas->backend == RENDER_NCURSES) {
+    wbkgd(canvas->win, COLOR_PAIR(1));
+  }
+  // box(win, 0, 0);
+}
+
+void draw_score(Canvas* canvas, long score) {
+  char text[32];
+  snprintf(text, sizeof(text), " Score: %ld ", score);
+  canvas_text(canvas, 0, 1, text);
+}
+
+void draw_paused(Canvas* canvas) {
+  const char* text = " Paused, press p to resume ";
+  int x = (canvas_width(canvas) - (int)strlen(text)) / 2;
+  canvas_text(canvas, 0, x > 0 ? x : 0, text);
+}
+
+// Returns how many glyphs of char_width it takes to cover width cells, a
+// glyph that only partly fits counts
+static int glyphs_across(int width, int char_width) {
+  return (width + char_width - 1) / char_width;
+}
+
+void draw_paddle(Canvas* canvas, const Paddle* paddle) {
+  canvas_put_run(canvas, paddle->rect.y, paddle->rect.x, paddle->glyph,
+                 glyphs_across(paddle->rect.w, paddle->char_width));
+}
+
+void draw_balls(Canvas* canvas, const BallPool* balls) {
+  for (int i = 0; i < balls->count; i++) {
+    Rect rect = ball_rect(balls, i);
+    canvas_put(canvas, rect.y, rect.x, balls->glyph);
+  }
+}
+
+void draw_brick(Canvas* canvas, const Brick* brick, int y, int health) {
+  if (health < 1 || health > LEVEL_MAX_HEALTH) {
+    return;
+  }
+
+  GlyphId glyph = GLYPH_BRICK_WEAK + health - 1;
+  canvas_put_run(canvas, y, brick->rect.x, glyph,
+                 glyphs_across(brick->rect.w, brick->char_width));
+}
+
+void draw_bricks(Canvas* canvas, const Brick* bricks, const int* health,
+                 const BrickBits* alive, const BrickScroll* scroll) {
+  for (int row = 0; row < alive->rows; row++) {
+    // A row shares its height and moves as one
+    int y = brick_screen_y(scroll, bricks[row * alive->cols].rect.y);
+    const uint64_t* words = brick_bits_row(alive, row);
+    for (int w = 0; w < alive->row_words; w++) {
+      for (uint64_t bits = words[w]; bits; bits &= bits - 1) {
+        int i = row * alive->cols + w * 64 + __builtin_ctzll(bits);
+        draw_brick(canvas, &bricks[i], y, health[i]);
+      }
+    }
+  }
+}
+
+void draw_drop(Canvas* canvas, const DropPool* drops) {
+  for (int i = 0; i < drops->count; i++) {
+    const Drop* drop = &drops->items[i];
+    canvas_put_run(canvas, drop->rect.y, drop->rect.x, drop->glyph,
+                   glyphs_across(drop->rect.w, drop->char_width));
+  }
+}
+
+void draw_effects(Canvas* canvas, const EffectPool* effects) {
+  for (int i = 0; i < effects->count; i++) {
+    int x = FIX_TO_CELL(effects->x[i]);
+    int y = FIX_TO_CELL(effects->y[i]);
+    if (effects->kind[i] == PARTICLE_DEBRIS) {
+      canvas_put(canvas, y, x, GLYPH_DEBRIS);
+    } else {
+      char text[16];
+      snprintf(text, sizeof(text), "+%d", effects->value[i]);
+      canvas_text(canvas, y, x, text);
+    }
+  }
+}
+
+void draw_text_box(Canvas* canvas, const SnapshotText* text) {
+  int x = canvas_width(canvas) - SNAPSHOT_TEXT_WIDTH - 1;
+  for (int i = 0; i < text->count; i++) {
+    char line[SNAPSHOT_TEXT_WIDTH + 1];
+    snprintf(line, sizeof(line), "%-*s", SNAPSHOT_TEXT_WIDTH, text->lines[i]);
+    canvas_text(canvas, 1 + i, x, line);
+  }
+}
+
+void erase_rect(Canvas* canvas, const Rect* rect) {
+  for (int y = rect->y; y < rect->y + rect->h; y++) {
+    canvas_put_run(canvas, y, rect->x, GLYPH_BLANK, rect->w);
+  }
+}
@@ -0,0 +1,158 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <ncurses.h>
+
+#include "ansi.h"
+#include "effects.h"
+#include "game.h"
+#include "snapshot.h"
+
+// Where the game frames go: through ncurses, or straight to the terminal as
+// diffed ANSI sequences. ncurses still reads the keyboard and draws the menus
+// with either.
+typedef enum {
+  RENDER_NCURSES,
+  RENDER_ANSI
+} RenderBackend;
+
+#ifndef DEFAULT_RENDERER
+#define DEFAULT_RENDERER RENDER_NCURSES
+#endif
+
+// The game window as the draw functions see it
+typedef struct {
+  RenderBackend backend;
+  WINDOW* win;
+  AnsiScreen ansi;
+
+  // The glyph set the draw functions index, with the cells ncurses takes
+  // prepared once instead of on every put
+  GlyphTable glyphs;
+  cchar_t cells[GLYPH_COUNT];
+
+  // A row of cells ncurses takes in one call, run_len of them already hold
+  // run_glyph
+  cchar_t* run;
+  int run_capacity;
+  int run_len;
+  GlyphId run_glyph;
+} Canvas;
+
+// Draws into the given ncurses window with the chosen backend and the active
+// glyph set
+void canvas_init(Canvas* canvas, RenderBackend backend, WINDOW* win);
+
+// Picks up the active glyph set after glyphs_select switched it
+void canvas_load_glyphs(Canvas* canvas);
+
+void canvas_free(Canvas* canvas);
+
+// Call before ncurses draws over the game, e.g. a menu. The two backends
+// then forget what the terminal shows and repaint all of it next time.
+void canvas_handoff(Canvas* canvas);
+
+int canvas_width(const Canvas* canvas);
+
+// Blanks the whole canvas
+void canvas_clear(Canvas* canvas);
+
+// Puts a glyph at row y, column x
+void canvas_put(Canvas* canvas, int y, int x, GlyphId glyph);
+
+// Puts count copies of a glyph side by side from row y, column x on, as one
+// run rather than a call per cell
+void canvas_put_run(Canvas* canvas, int y, int x, GlyphId glyph, int count);
+
+// Puts ASCII text at row y, column x
+void canvas_text(Canvas* canvas, int y, int x, const char* text);
+
+// Remembers what was drawn on the previous frame so the next one only touches
+// the cells that changed: the old and new spots of the paddle, balls and drops
+// plus the bricks whose health differs from the last frame drawn, however
+// many snapshots were skipped in between. The debris and popups of broken
+// bricks live here too, the simulation never sees them. Nothing is flushed
+// until present_frame commits everything at once.
+typedef struct {
+  Arena arena;  // the lists below, sized for the round up front
+  Rect paddle;
+
+  Rect* balls;
+  int ball_count;
+
+  Rect* drops;
+  int drop_count;
+
+  int* health;      // brick health on screen, for the live bricks
+  BrickBits alive;  // the bricks on screen
+  int brick_total;
+  int shift;  // how far the bricks on screen have scrolled
+
+  EffectPool effects;  // what is on screen of them, until the next update
+
+  long score;  // the score on screen, -1 before it is first drawn
+
+  unsigned redraws;  // the snapshot's redraw count last drawn
+  int paused;        // the pause notice is on screen
+  int full_redraw;
+} Compositor;
+
+// Prepares a compositor for the given round, the first frame redraws
+// everything
+void compositor_init(Compositor* comp, const Game* game,
+                     const EffectsConfig* effects);
+
+// Releases the compositor's lists
+void compositor_free(Compositor* comp);
+
+// Forces the next frame to redraw the whole window, e.g. after a menu
+void compositor_invalidate(Compositor* comp);
+
+// Draws the changes since the previous frame into the window
+void render_frame(Canvas* canvas, Compositor* comp,
+                  const GameSnapshot* snapshot);
+
+// Sends the frame to the terminal in one update, ncurses' doupdate or a
+// single write() for the ANSI backend. Returns the bytes sent when
+// present_counts_bytes says they are known, otherwise 0.
+size_t present_frame(Canvas* canvas);
+
+// Returns 1 when present_frame knows what it sent: always with the ANSI
+// backend, with ncurses only in a -DTRACE_TERMINAL_BYTES build
+int present_counts_bytes(const Canvas* canvas);
+
+// Draws the window frame (border) and applies background color
+void draw_window(Canvas* canvas);
+
+// Draw the score along the top edge of the window
+void draw_score(Canvas* canvas, long score);
+
+// Draws the pause notice in the middle of the top edge, a full redraw takes
+// it away again
+void draw_paused(Canvas* canvas);
+
+// Draw the paddle
+void draw_paddle(Canvas* canvas, const Paddle* paddle);
+
+// Draw the ball
+void draw_balls(Canvas* canvas, const BallPool* balls);
+
+// Draws a brick on window row y, where an endless board has scrolled it to
+void draw_brick(Canvas* canvas, const Brick* brick, int y, int health);
+
+// Draws the bricks set in alive
+void draw_bricks(Canvas* canvas, const Brick* bricks, const int* health,
+                 const BrickBits* alive, const BrickScroll* scroll);
+
+void draw_drop(Canvas* canvas, const DropPool* drops);
+
+// Draws the debris and score popups
+void draw_effects(Canvas* canvas, const EffectPool* effects);
+
+// Draws the text lines right aligned below the top edge
+void draw_text_box(Canvas* canvas, const SnapshotText* text);
+
+// Blanks every cell covered by rect
+void erase_rect(Canvas* canvas, const Rect* rect);
+
+#endif
@@ -0,0 +1,197 @@
+#define _XOPEN_SOURCE 700
+
+#include "replay.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void put_le(uint8_t* bytes, uint64_t value, int size) {
+  for (int i = 0; i < size; i++) {
+    bytes[i] = (value >> (8 * i)) & 0xff;
+  }
+}
+
+static uint64_t get_le(const uint8_t* bytes, int size) {
+  uint64_t value = 0;
+  for (int i = 0; i < size; i++) {
+    value |= (uint64_t)bytes[i] << (8 * i);
+  }
+  return value;
+}
+
+static int input_code(const GameInput* input) {
+  return (input->paddle_dir + 1) | (input->launch ? 4 : 0);
+}
+
+static void put_varint(FILE* file, uint64_t value) {
+  while (value >= 0x80) {
+    fputc((int)(value & 0x7f) | 0x80, file);
+    value >>= 7;
+  }
+  fputc((int)value, file);
+}
+
+void replay_header_init(ReplayHeader* header, const WindowConfig* win_conf,
+                        const GameConfig* config) {
+  header->seed = config->seed;
+  header->width = win_conf->rect.w;
+  header->height = win_conf->rect.h;
+  header->brick_cols = config->brick_cols;
+  header->brick_rows = config->brick_rows;
+  header->max_balls = config->max_balls;
+  header->level_hash = config->level ? level_hash(config->level) : 0;
+  header->glyphs = glyphs_active()->set;
+  header->tick_rate = config->tick_rate;
+  header->ball_speed = config->ball_speed;
+  header->scroll_period = config->scroll_period;
+}
+
+int recorder_open(InputRecorder* rec, const char* path,
+                  const ReplayHeader* header) {
+  rec->code = -1;
+  rec->run = 0;
+  rec->file = fopen(path, "wb");
+  if (rec->file == NULL) {
+    fprintf(stderr, "Error: cannot create %s: %s\n", path, strerror(errno));
+    return 0;
+  }
+
+  uint8_t bytes[REPLAY_HEADER_SIZE];
+  memcpy(bytes, REPLAY_MAGIC, 4);
+  bytes[4] = REPLAY_VERSION;
+  put_le(bytes + 5, header->seed, 8);
+  put_le(bytes + 13, header->width, 2);
+  put_le(bytes + 15, header->height, 2);
+  put_le(bytes + 17, header->brick_cols, 2);
+  put_le(bytes + 19, header->brick_rows, 2);
+  put_le(bytes + 21, header->max_balls, 4);
+  put_le(bytes + 25, header->level_hash, 4);
+  bytes[29] = header->glyphs;
+  put_le(bytes + 30, header->tick_rate, 2);
+  put_le(bytes + 32, header->ball_speed, 2);
+  put_le(bytes + 34, header->scroll_period, 4);
+  fwrite(bytes, 1, sizeof(bytes), rec->file);
+  return 1;
+}
+
+// Writes out the run collected so far
+static void flush_run(InputRecorder* rec) {
+  if (rec->run > 0) {
+    put_varint(rec->file, (rec->run << 3) | rec->code);
+  }
+  rec->run = 0;
+}
+
+void recorder_tick(InputRecorder* rec, const GameInput* input) {
+  int code = input_code(input);
+  if (code != rec->code) {
+    flush_run(rec);
+    rec->code = code;
+  }
+  rec->run++;
+}
+
+void recorder_end_round(InputRecorder* rec) {
+  flush_run(rec);
+  put_varint(rec->file, REPLAY_ROUND_CODE);
+  rec->code = -1;
+}
+
+int recorder_close(InputRecorder* rec) {
+  flush_run(rec);
+  int ok = !ferror(rec->file);
+  ok = fclose(rec->file) == 0 && ok;
+  rec->file = NULL;
+  return ok;
+}
+
+int player_open(InputPlayer* player, const char* path) {
+  memset(player, 0, sizeof(*player));
+
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "Error: cannot open %s: %s\n", path, strerror(errno));
+    return 0;
+  }
+
+  // Recordings are small, a long session is a few kilobytes
+  size_t capacity = 4096;
+  player->data = malloc(capacity);
+  VALIDATE(player->data);
+  size_t read;
+  while ((read = fread(player->data + player->size, 1,
+                       capacity - player->size, file)) > 0) {
+    player->size += read;
+    if (player->size == capacity) {
+      capacity *= 2;
+      player->data = realloc(player->data, capacity);
+      VALIDATE(player->data);
+    }
+  }
+  fclose(file);
+
+  const uint8_t* bytes = player->data;
+  if (player->size < REPLAY_HEADER_SIZE ||
+      memcmp(bytes, REPLAY_MAGIC, 4) != 0 || bytes[4] != REPLAY_VERSION ||
+      bytes[29] >= GLYPH_SET_COUNT || get_le(bytes + 30, 2) == 0) {
+    fprintf(stderr, "Error: %s is not a recording (version %d)\n", path,
+            REPLAY_VERSION);
+    player_close(player);
+    return 0;
+  }
+
+  ReplayHeader* header = &player->header;
+  header->seed = get_le(bytes + 5, 8);
+  header->width = (int)get_le(bytes + 13, 2);
+  header->height = (int)get_le(bytes + 15, 2);
+  header->brick_cols = (int)get_le(bytes + 17, 2);
+  header->brick_rows = (int)get_le(bytes + 19, 2);
+  header->max_balls = (int)get_le(bytes + 21, 4);
+  header->level_hash = (uint32_t)get_le(bytes + 25, 4);
+  header->glyphs = bytes[29];
+  header->tick_rate = (int)get_le(bytes + 30, 2);
+  header->ball_speed = (int)get_le(bytes + 32, 2);
+  header->scroll_period = (int)get_le(bytes + 34, 4);
+
+  player->pos = REPLAY_HEADER_SIZE;
+  return 1;
+}
+
+ReplayStep player_next(InputPlayer* player, GameInput* input) {
+  while (player->left == 0) {
+    if (player->pos >= player->size) {
+      return REPLAY_END;
+    }
+
+    uint64_t value = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+      if (player->pos >= player->size || shift > 63) {
+        // A run cut off by a truncated file ends the replay
+        return REPLAY_END;
+      }
+      byte = player->data[player->pos++];
+      value |= (uint64_t)(byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+
+    player->code = value & 7;
+    player->left = value >> 3;
+    if (player->code == REPLAY_ROUND_CODE) {
+      player->left = 0;
+      return REPLAY_ROUND_END;
+    }
+  }
+
+  player->left--;
+  input->paddle_dir = (player->code & 3) - 1;
+  input->launch = (player->code & 4) != 0;
+  return REPLAY_TICK;
+}
+
+void player_close(InputPlayer* player) {
+  free(player->data);
+  memset(player, 0, sizeof(*player));
+}
@@ -0,0 +1,98 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "game.h"
+
+// A recording holds what it takes to re-simulate a session: the window and
+// board settings, the seed of the first round and the input of every tick.
+// Each later round is seeded with the previous seed plus one.
+//
+// Header, all fields little-endian:
+//   0  magic "BKRP"
+//   4  version (1 byte)
+//   5  seed (8 bytes)
+//  13  width, height (2 bytes each)
+//  17  brick_cols, brick_rows (2 bytes each)
+//  21  max_balls (4 bytes)
+//  25  level_hash of the level played, 0 for a random board (4 bytes)
+//  29  glyph set, it decides the board geometry (1 byte)
+//  30  tick_rate, ball_speed (2 bytes each)
+//  34  scroll_period, 0 unless the board was endless (4 bytes)
+//
+// The input follows as runs: one LEB128 varint per run holding
+// (ticks << 3) | code, where the code packs the paddle direction and the
+// launch flag. A code of REPLAY_ROUND_CODE marks the start of the next round.
+#define REPLAY_MAGIC "BKRP"
+#define REPLAY_VERSION 5
+#define REPLAY_HEADER_SIZE 38
+#define REPLAY_ROUND_CODE 7
+
+typedef struct {
+  uint64_t seed;
+  int width;
+  int height;
+  int brick_cols;
+  int brick_rows;
+  int max_balls;
+  uint32_t level_hash;
+  GlyphSet glyphs;
+  int tick_rate;
+  int ball_speed;
+  int scroll_period;
+} ReplayHeader;
+
+// Writes the input of a session as it is played
+typedef struct {
+  FILE* file;
+  int code;      // input of the current run, -1 before the first tick
+  uint64_t run;  // ticks the current run has lasted so far
+} InputRecorder;
+
+typedef enum {
+  REPLAY_TICK,       // the next tick's input was read
+  REPLAY_ROUND_END,  // the recorded round ended, the next one starts
+  REPLAY_END
+} ReplayStep;
+
+// Reads a recording back tick by tick
+typedef struct {
+  ReplayHeader header;
+  uint8_t* data;
+  size_t size;
+  size_t pos;
+  int code;
+  uint64_t left;  // ticks left in the current run
+} InputPlayer;
+
+// Fills a header for rounds played in this window with this config
+void replay_header_init(ReplayHeader* header, const WindowConfig* win_conf,
+                        const GameConfig* config);
+
+// Creates the recording file and writes its header. Returns 1 on success,
+// otherwise prints why to stderr and returns 0.
+int recorder_open(InputRecorder* rec, const char* path,
+                  const ReplayHeader* header);
+
+// Records the input of one simulated tick
+void recorder_tick(InputRecorder* rec, const GameInput* input);
+
+// Records that the current round ended and the next one starts
+void recorder_end_round(InputRecorder* rec);
+
+// Writes the last run and closes the file, returns 0 on a write error
+int recorder_close(InputRecorder* rec);
+
+// Reads a whole recording. Returns 1 on success, otherwise prints why to
+// stderr and returns 0.
+int player_open(InputPlayer* player, const char* path);
+
+// Reads the next step of the recording
+ReplayStep player_next(InputPlayer* player, GameInput* input);
+
+void player_close(InputPlayer* player);
+
+#endif
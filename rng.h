@@ -0,0 +1,47 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// xoshiro256** generator. Every game owns one, so a round is reproduced
+// exactly from its seed no matter what else calls rand() in the process.
+typedef struct {
+  uint64_t s[4];
+} Rng;
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+// Expands a 64-bit seed into the generator state with splitmix64, so nearby
+// seeds still give unrelated sequences
+static inline void rng_seed(Rng* rng, uint64_t seed) {
+  for (int i = 0; i < 4; i++) {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    rng->s[i] = z ^ (z >> 31);
+  }
+}
+
+static inline uint64_t rng_next(Rng* rng) {
+  uint64_t* s = rng->s;
+  uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rng_rotl(s[3], 45);
+
+  return result;
+}
+
+// Returns a number in [0, n), by scaling the top 32 bits instead of a modulo
+static inline int rng_below(Rng* rng, uint32_t n) {
+  return (int)(((rng_next(rng) >> 32) * n) >> 32);
+}
+
+#endif
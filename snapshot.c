@@ -0,0 +1,95 @@
+#include "snapshot.h"
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <string.h>
+
+void snapshot_init(GameSnapshot* snapshot, const Game* game) {
+  memset(snapshot, 0, sizeof(*snapshot));
+
+  size_t balls = game->balls.capacity + 1;
+  size_t drops = game->drops.capacity + 1;
+  size_t bricks = game->brick_total + 1;
+  arena_init(&snapshot->arena,
+             balls * (sizeof(int) * 4 + 1) + drops * sizeof(Drop) +
+                 bricks * (sizeof(int) + sizeof(uint64_t)) +
+                 5 * alignof(max_align_t));
+
+  init_ball_pool(&snapshot->balls, game->balls.capacity, &snapshot->arena);
+  init_drop_pool(&snapshot->drops, game->drops.capacity, &snapshot->arena);
+  snapshot->health = arena_alloc(&snapshot->arena, sizeof(int) * bricks);
+  init_brick_bits(&snapshot->alive, game->brick_cols, game->brick_rows,
+                  &snapshot->arena);
+  snapshot->bricks = game->bricks;
+  snapshot->brick_total = game->brick_total;
+}
+
+void snapshot_free(GameSnapshot* snapshot) {
+  arena_free(&snapshot->arena);
+  snapshot->health = NULL;
+}
+
+void snapshot_capture(GameSnapshot* snapshot, const Game* game) {
+  snapshot->paddle = game->paddle;
+
+  BallPool* balls = &snapshot->balls;
+  const BallPool* live = &game->balls;
+  memcpy(balls->x, live->x, sizeof(int) * live->count);
+  memcpy(balls->y, live->y, sizeof(int) * live->count);
+  balls->count = live->count;
+  balls->glyph = live->glyph;
+  balls->w = live->w;
+  balls->h = live->h;
+
+  memcpy(snapshot->drops.items, game->drops.items,
+         sizeof(Drop) * game->drops.count);
+  snapshot->drops.count = game->drops.count;
+
+  memcpy(snapshot->health, game->packed.health,
+         sizeof(int) * game->brick_total);
+  copy_brick_bits(&snapshot->alive, &game->packed.alive);
+  snapshot->scroll = game->packed.scroll;
+  snapshot->bricks = game->bricks;
+  snapshot->score = game->score;
+}
+
+void snapshots_init(SnapshotBuffer* buffer, const Game* game) {
+  for (int i = 0; i < 3; i++) {
+    snapshot_init(&buffer->slots[i], game);
+  }
+  buffer->back = 0;
+  buffer->front = 1;
+  atomic_init(&buffer->middle, 2);
+}
+
+void snapshots_free(SnapshotBuffer* buffer) {
+  for (int i = 0; i < 3; i++) {
+    snapshot_free(&buffer->slots[i]);
+  }
+}
+
+GameSnapshot* snapshots_back(SnapshotBuffer* buffer) {
+  return &buffer->slots[buffer->back];
+}
+
+void snapshots_publish(SnapshotBuffer* buffer) {
+  // Release makes the filled slot visible with the swap, acquire hands over
+  // whatever the reader left in the slot that comes back
+  int old = atomic_exchange_explicit(&buffer->middle,
+                                     buffer->back | SNAPSHOT_FRESH,
+                                     memory_order_acq_rel);
+  buffer->back = old & SNAPSHOT_SLOT;
+}
+
+GameSnapshot* snapshots_acquire(SnapshotBuffer* buffer) {
+  if (!(atomic_load_explicit(&buffer->middle, memory_order_relaxed) &
+        SNAPSHOT_FRESH)) {
+    return NULL;
+  }
+
+  // Only the writer sets the fresh bit, so it is still set for the swap
+  int old = atomic_exchange_explicit(&buffer->middle, buffer->front,
+                                     memory_order_acq_rel);
+  buffer->front = old & SNAPSHOT_SLOT;
+  return &buffer->slots[buffer->front];
+}
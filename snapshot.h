@@ -0,0 +1,79 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdatomic.h>
+
+#include "game.h"
+
+// Text drawn over the top right corner of the board, e.g. the trace overlay
+#define SNAPSHOT_TEXT_LINES 16
+#define SNAPSHOT_TEXT_WIDTH 44
+
+typedef struct {
+  int count;
+  char lines[SNAPSHOT_TEXT_LINES][SNAPSHOT_TEXT_WIDTH + 1];
+} SnapshotText;
+
+// What the renderer needs of a round at one point in time, copied out of the
+// game so it can be drawn while the simulation moves on. The brick geometry
+// does not change during a round and is shared, their health and how far an
+// endless board has scrolled are copied. The
+// arrays are sized for the round up front, capturing never allocates.
+typedef struct {
+  Arena arena;
+  Paddle paddle;
+  BallPool balls;  // positions only
+  DropPool drops;
+  const Brick* bricks;
+  int* health;
+  BrickBits alive;
+  BrickScroll scroll;
+  int brick_total;
+  long score;
+
+  // Filled in by the frontend for every snapshot, capturing leaves them alone
+  unsigned redraws;  // bumped whenever the whole window has to be redrawn
+  int paused;
+  SnapshotText overlay;
+} GameSnapshot;
+
+// Sizes the snapshot for the given round
+void snapshot_init(GameSnapshot* snapshot, const Game* game);
+
+void snapshot_free(GameSnapshot* snapshot);
+
+// Copies the game's current state into the snapshot
+void snapshot_capture(GameSnapshot* snapshot, const Game* game);
+
+// Bit of SnapshotBuffer.middle that marks a slot the reader has not taken
+#define SNAPSHOT_FRESH 4
+#define SNAPSHOT_SLOT 3
+
+// Three snapshots passed from one writer thread to one reader thread without
+// a lock. The writer fills its back slot and publishes it by swapping it with
+// the middle one, the reader swaps its front slot for the middle one when
+// that is fresh. Neither side ever waits for the other: a snapshot published
+// while the reader is still drawing replaces the previous one unseen, so the
+// reader always gets the latest complete one.
+typedef struct {
+  GameSnapshot slots[3];
+  int back;           // owned by the writer
+  int front;          // owned by the reader
+  atomic_int middle;  // slot index, plus SNAPSHOT_FRESH until it is taken
+} SnapshotBuffer;
+
+void snapshots_init(SnapshotBuffer* buffer, const Game* game);
+
+void snapshots_free(SnapshotBuffer* buffer);
+
+// Returns the slot the writer fills next
+GameSnapshot* snapshots_back(SnapshotBuffer* buffer);
+
+// Makes the filled back slot the latest snapshot
+void snapshots_publish(SnapshotBuffer* buffer);
+
+// Returns the latest snapshot when one was published since the last call,
+// otherwise NULL. The reader owns it until its next call.
+GameSnapshot* snapshots_acquire(SnapshotBuffer* buffer);
+
+#endif
@@ -0,0 +1,136 @@
+#define _XOPEN_SOURCE 700
+
+#include "timing.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+int scheduler_init(FrameScheduler* sched, int tick_rate) {
+  if (tick_rate <= 0) {
+    tick_rate = DEFAULT_TICK_RATE;
+  }
+
+  sched->tick_ns = NS_PER_SEC / tick_rate;
+  sched->paused = 0;
+  sched->frames = 0;
+  sched->ticks = 0;
+  sched->late_frames = 0;
+  sched->overruns = 0;
+
+  sched->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (sched->timer_fd < 0) {
+    fprintf(stderr, "Error: cannot create the frame timer: %s\n",
+            strerror(errno));
+    return 0;
+  }
+
+  scheduler_resync(sched);
+  return 1;
+}
+
+void scheduler_free(FrameScheduler* sched) {
+  if (sched->timer_fd >= 0) {
+    close(sched->timer_fd);
+  }
+  sched->timer_fd = -1;
+}
+
+// Fires the timer every tick starting one tick from now, or stops it
+static void arm_timer(FrameScheduler* sched, int on) {
+  struct itimerspec spec = {0};
+  if (on) {
+    spec.it_interval.tv_sec = sched->tick_ns / NS_PER_SEC;
+    spec.it_interval.tv_nsec = sched->tick_ns % NS_PER_SEC;
+    spec.it_value = spec.it_interval;
+  }
+  timerfd_settime(sched->timer_fd, 0, &spec, NULL);
+}
+
+void scheduler_resync(FrameScheduler* sched) {
+  // Start with one tick banked so the first frame advances the game
+  sched->accumulator = sched->tick_ns;
+  sched->last_time = now_ns();
+  if (!sched->paused) {
+    arm_timer(sched, 1);
+  }
+}
+
+int scheduler_begin_frame(FrameScheduler* sched) {
+  if (sched->paused) {
+    return 0;
+  }
+
+  uint64_t now = now_ns();
+  sched->accumulator += now - sched->last_time;
+  sched->last_time = now;
+
+  uint64_t ticks = sched->accumulator / sched->tick_ns;
+  sched->accumulator -= ticks * sched->tick_ns;
+
+  if (ticks > MAX_CATCHUP_TICKS) {
+    sched->overruns += ticks - MAX_CATCHUP_TICKS;
+    ticks = MAX_CATCHUP_TICKS;
+  }
+
+  sched->frames++;
+  sched->ticks += ticks;
+  return (int)ticks;
+}
+
+SchedWake scheduler_wait(FrameScheduler* sched, int input_fd) {
+  struct pollfd fds[2] = {
+      {.fd = sched->timer_fd, .events = POLLIN},
+      {.fd = input_fd, .events = POLLIN},
+  };
+
+  int ready;
+  do {
+    ready = poll(fds, input_fd >= 0 ? 2 : 1, -1);
+  } while (ready < 0 && errno == EINTR);
+  if (ready < 0) {
+    return SCHED_WAKE_FRAME;
+  }
+
+  // A terminal that hung up also reports POLLIN, with nothing left to read,
+  // so this comes first or the loop would spin on the dead input
+  if (fds[1].revents & (POLLHUP | POLLERR | POLLNVAL)) {
+    return SCHED_WAKE_HANGUP;
+  }
+
+  if (fds[0].revents & POLLIN) {
+    // More than one expiry means the frame ran past the next deadline
+    uint64_t expirations = 0;
+    if (read(sched->timer_fd, &expirations, sizeof(expirations)) ==
+            sizeof(expirations) &&
+        expirations > 1) {
+      sched->late_frames++;
+    }
+    return SCHED_WAKE_FRAME;
+  }
+
+  if (fds[1].revents & POLLIN) {
+    return SCHED_WAKE_INPUT;
+  }
+  return SCHED_WAKE_FRAME;
+}
+
+void scheduler_pause(FrameScheduler* sched) {
+  sched->paused = 1;
+  arm_timer(sched, 0);
+}
+
+void scheduler_resume(FrameScheduler* sched) {
+  sched->paused = 0;
+  scheduler_resync(sched);
+}
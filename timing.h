@@ -0,0 +1,66 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+
+#define NS_PER_SEC 1000000000ULL
+
+#define DEFAULT_TICK_RATE 24
+
+// Most ticks a single frame may run to catch up, anything beyond that is
+// dropped and counted as an overrun
+#define MAX_CATCHUP_TICKS 5
+
+// Fixed-timestep frame scheduler on CLOCK_MONOTONIC. Wall time is fed into an
+// accumulator that is drained in whole ticks. Between frames the process
+// blocks in poll() on a periodic timerfd and the input, so the time spent on
+// input and drawing is not added on top of the frame period and nothing runs
+// while there is nothing to do.
+typedef struct {
+  uint64_t tick_ns;
+  uint64_t accumulator;
+  uint64_t last_time;
+  int timer_fd;
+  int paused;
+
+  uint64_t frames;
+  uint64_t ticks;
+  uint64_t late_frames;  // frames that finished after their deadline
+  uint64_t overruns;     // ticks dropped because a frame fell too far behind
+} FrameScheduler;
+
+// Why scheduler_wait returned
+typedef enum {
+  SCHED_WAKE_FRAME,   // the next frame is due
+  SCHED_WAKE_INPUT,   // the input has something to read
+  SCHED_WAKE_HANGUP   // the input was closed
+} SchedWake;
+
+// Returns the current CLOCK_MONOTONIC time in nanoseconds
+uint64_t now_ns(void);
+
+// Starts the scheduler at the given number of ticks per second, returns 0
+// and prints why when the timer cannot be created
+int scheduler_init(FrameScheduler* sched, int tick_rate);
+
+void scheduler_free(FrameScheduler* sched);
+
+// Restarts the clock without touching the counters, e.g. after a menu kept the
+// game loop waiting
+void scheduler_resync(FrameScheduler* sched);
+
+// Adds the time since the previous frame to the accumulator and returns how
+// many simulation ticks the current frame has to run, none while paused
+int scheduler_begin_frame(FrameScheduler* sched);
+
+// Sleeps until the next frame is due or input_fd (-1 for none) becomes
+// readable. While paused only the input can wake it.
+SchedWake scheduler_wait(FrameScheduler* sched, int input_fd);
+
+// Stops the tick timer, frames then only follow the input
+void scheduler_pause(FrameScheduler* sched);
+
+// Starts the timer again, the paused time is not made up for
+void scheduler_resume(FrameScheduler* sched);
+
+#endif
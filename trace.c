@@ -0,0 +1,200 @@
+#define _XOPEN_SOURCE 700
+
+#include "trace.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "timing.h"
+
+#ifndef NO_TRACE
+
+_Static_assert(TRACE_OVERLAY_LINES <= SNAPSHOT_TEXT_LINES,
+               "the overlay does not fit a snapshot");
+
+static const char* frame_phase_names[FRAME_PHASE_COUNT] = {
+    [FRAME_INPUT] = "input", [FRAME_SIMULATE] = "simulate",
+    [FRAME_PUBLISH] = "publish", [FRAME_DRAW] = "draw",
+    [FRAME_FLUSH] = "flush", [FRAME_WAIT] = "wait",
+    [FRAME_TOTAL] = "frame",
+};
+
+void trace_init(FrameTrace* trace) {
+  memset(trace, 0, sizeof(*trace));
+  trace->profile.hist = trace->tick;
+}
+
+void trace_attach(FrameTrace* trace, Game* game) {
+  game->profile = &trace->profile;
+}
+
+void trace_frame_begin(FrameTrace* trace) {
+  trace->frame_start = now_ns();
+  trace->phase_start = trace->frame_start;
+}
+
+void trace_phase_begin(FrameTrace* trace) { trace->phase_start = now_ns(); }
+
+void trace_phase(FrameTrace* trace, FramePhase phase) {
+  uint64_t now = now_ns();
+  hist_record(&trace->frame[phase], now - trace->phase_start);
+  trace->phase_start = now;
+}
+
+void trace_frame_end(FrameTrace* trace) {
+  hist_record(&trace->frame[FRAME_TOTAL], now_ns() - trace->frame_start);
+}
+
+void trace_bytes(FrameTrace* trace, size_t bytes) {
+  hist_record(&trace->bytes, bytes);
+}
+
+void trace_merge(FrameTrace* trace, const FrameTrace* from) {
+  for (int i = 0; i < FRAME_PHASE_COUNT; i++) {
+    hist_merge(&trace->frame[i], &from->frame[i]);
+  }
+  for (int i = 0; i < PHASE_COUNT; i++) {
+    hist_merge(&trace->tick[i], &from->tick[i]);
+  }
+  hist_merge(&trace->bytes, &from->bytes);
+  hist_merge(&trace->input, &from->input);
+}
+
+int trace_toggle_overlay(FrameTrace* trace) {
+  trace->overlay = !trace->overlay;
+  trace->overlay_time = 0;
+  return !trace->overlay;
+}
+
+static void overlay_line(SnapshotText* text, const char* name,
+                         const LatencyHist* hist, double scale) {
+  if (hist->count == 0) {
+    return;
+  }
+  snprintf(text->lines[text->count++], TRACE_OVERLAY_WIDTH + 1,
+           "%-14.14s %9.1f %9.1f %9.1f", name,
+           hist_percentile(hist, 0.5) * scale,
+           hist_percentile(hist, 0.99) * scale, hist->max * scale);
+}
+
+// Formats the rows of the trace again once the last ones are old enough
+static void refresh_overlay(FrameTrace* trace, int header) {
+  uint64_t now = now_ns();
+  if (now - trace->overlay_time < TRACE_OVERLAY_PERIOD_NS) {
+    return;
+  }
+  trace->overlay_time = now;
+
+  SnapshotText* text = &trace->overlay_text;
+  text->count = 0;
+  if (header) {
+    snprintf(text->lines[text->count++], TRACE_OVERLAY_WIDTH + 1,
+             "%-14s %9s %9s %9s", "phase (us)", "p50", "p99", "max");
+  }
+  for (int i = 0; i < FRAME_PHASE_COUNT; i++) {
+    overlay_line(text, frame_phase_names[i], &trace->frame[i], 1e-3);
+  }
+  for (int i = 0; i < PHASE_COUNT; i++) {
+    overlay_line(text, game_phase_name(i), &trace->tick[i], 1e-3);
+  }
+  overlay_line(text, "input lag", &trace->input, 1e-3);
+  overlay_line(text, "bytes/frame", &trace->bytes, 1.0);
+}
+
+void trace_overlay_text(FrameTrace* trace, SnapshotText* text) {
+  if (!trace->overlay) {
+    text->count = 0;
+    return;
+  }
+
+  refresh_overlay(trace, 1);
+  *text = trace->overlay_text;
+}
+
+void trace_append_overlay(FrameTrace* trace, SnapshotText* text) {
+  if (text->count == 0) {
+    return;
+  }
+
+  refresh_overlay(trace, 0);
+  const SnapshotText* own = &trace->overlay_text;
+  for (int i = 0; i < own->count && text->count < SNAPSHOT_TEXT_LINES; i++) {
+    memcpy(text->lines[text->count++], own->lines[i], sizeof(own->lines[i]));
+  }
+}
+
+// Calls row for every histogram, with the group and the name it is listed
+// under and its unit
+static void each_hist(const FrameTrace* trace, FILE* out,
+                      void (*row)(FILE*, const char*, const char*,
+                                  const char*, const LatencyHist*, int)) {
+  int first = 1;
+  for (int i = 0; i < FRAME_PHASE_COUNT; i++) {
+    row(out, "frame", frame_phase_names[i], "ns", &trace->frame[i], first);
+    first = 0;
+  }
+  for (int i = 0; i < PHASE_COUNT; i++) {
+    row(out, "tick", game_phase_name(i), "ns", &trace->tick[i], 0);
+  }
+  row(out, "input", "key_to_tick", "ns", &trace->input, 0);
+  row(out, "terminal", "bytes_per_frame", "bytes", &trace->bytes, 0);
+}
+
+static void csv_row(FILE* out, const char* group, const char* name,
+                    const char* unit, const LatencyHist* hist, int first) {
+  if (first) {
+    fprintf(out, "group,phase,unit,count,mean,p50,p99,max\n");
+  }
+  fprintf(out, "%s,%s,%s,%llu,%.1f,%llu,%llu,%llu\n", group, name, unit,
+          (unsigned long long)hist->count, hist_mean(hist),
+          (unsigned long long)hist_percentile(hist, 0.5),
+          (unsigned long long)hist_percentile(hist, 0.99),
+          (unsigned long long)hist->max);
+}
+
+static void json_row(FILE* out, const char* group, const char* name,
+                     const char* unit, const LatencyHist* hist, int first) {
+  fprintf(out,
+          "%s  {\"group\": \"%s\", \"phase\": \"%s\", \"unit\": \"%s\", "
+          "\"count\": %llu, \"mean\": %.1f, \"p50\": %llu, \"p99\": %llu, "
+          "\"max\": %llu}",
+          first ? "" : ",\n", group, name, unit,
+          (unsigned long long)hist->count, hist_mean(hist),
+          (unsigned long long)hist_percentile(hist, 0.5),
+          (unsigned long long)hist_percentile(hist, 0.99),
+          (unsigned long long)hist->max);
+}
+
+int trace_write(const FrameTrace* trace, const char* path) {
+  FILE* out = fopen(path, "w");
+  if (out == NULL) {
+    fprintf(stderr, "Error: cannot create %s: %s\n", path, strerror(errno));
+    return 0;
+  }
+
+  size_t len = strlen(path);
+  if (len >= 5 && strcmp(path + len - 5, ".json") == 0) {
+    fprintf(out, "[\n");
+    each_hist(trace, out, json_row);
+    fprintf(out, "\n]\n");
+  } else {
+    each_hist(trace, out, csv_row);
+  }
+
+  if (fclose(out) != 0) {
+    fprintf(stderr, "Error: cannot write %s: %s\n", path, strerror(errno));
+    return 0;
+  }
+  return 1;
+}
+
+#else
+
+int trace_write(const FrameTrace* trace, const char* path) {
+  (void)trace;
+  fprintf(stderr, "Error: %s not written, built with -DNO_TRACE\n", path);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "hist.h"
+#include "snapshot.h"
+
+// Parts of a frame of the interactive loop
+typedef enum {
+  FRAME_INPUT,     // reading the keyboard
+  FRAME_SIMULATE,  // the game ticks run by the frame
+  FRAME_PUBLISH,   // copying the state out for the renderer
+  FRAME_DRAW,      // drawing into the window
+  FRAME_FLUSH,     // sending the frame to the terminal
+  FRAME_WAIT,      // sleeping until the next frame
+  FRAME_TOTAL,
+  FRAME_PHASE_COUNT
+} FramePhase;
+
+// Key that shows and hides the overlay
+#define TRACE_OVERLAY_KEY 'o'
+
+#define TRACE_OVERLAY_LINES (FRAME_PHASE_COUNT + PHASE_COUNT + 3)
+#define TRACE_OVERLAY_WIDTH SNAPSHOT_TEXT_WIDTH
+
+// How often the overlay figures are refreshed, redrawing them every frame
+// would mostly measure the overlay itself
+#define TRACE_OVERLAY_PERIOD_NS 250000000ULL
+
+#ifndef NO_TRACE
+
+// Frame instrumentation: every phase of a frame and of a game tick is timed
+// on the monotonic clock into a latency histogram, and the bytes of every
+// frame sent to the terminal are counted. Build with -DNO_TRACE to compile it
+// out, the calls in the game loop then do nothing. A trace is only touched by
+// one thread, the render thread keeps its own and it is merged in later.
+typedef struct {
+  LatencyHist frame[FRAME_PHASE_COUNT];
+  LatencyHist tick[PHASE_COUNT];
+  LatencyHist bytes;  // bytes of every frame sent to the terminal
+  LatencyHist input;  // from reading a key to the tick that applied it
+  GameProfile profile;
+
+  uint64_t frame_start;
+  uint64_t phase_start;
+
+  int overlay;
+  uint64_t overlay_time;
+  SnapshotText overlay_text;
+} FrameTrace;
+
+void trace_init(FrameTrace* trace);
+
+// Lets the game record its per-phase timings into the trace
+void trace_attach(FrameTrace* trace, Game* game);
+
+// Returns the histogram the input latency goes to
+static inline LatencyHist* trace_input_hist(FrameTrace* trace) {
+  return &trace->input;
+}
+
+void trace_frame_begin(FrameTrace* trace);
+
+// Starts timing phases now without starting a frame, for a thread that only
+// runs some of the phases
+void trace_phase_begin(FrameTrace* trace);
+
+// Ends the given phase of the frame, the next one starts now
+void trace_phase(FrameTrace* trace, FramePhase phase);
+
+void trace_frame_end(FrameTrace* trace);
+
+// Records the bytes present_frame sent for a frame
+void trace_bytes(FrameTrace* trace, size_t bytes);
+
+// Adds every histogram of from to trace
+void trace_merge(FrameTrace* trace, const FrameTrace* from);
+
+// Shows or hides the overlay, returns 1 when it was hidden and the cells
+// under it need a redraw
+int trace_toggle_overlay(FrameTrace* trace);
+
+// Puts the overlay into text when it is shown, a header and a row for every
+// histogram with samples, otherwise leaves text empty
+void trace_overlay_text(FrameTrace* trace, SnapshotText* text);
+
+// Adds the rows of this trace's histograms to an overlay another trace has
+// put into text, when that one is shown
+void trace_append_overlay(FrameTrace* trace, SnapshotText* text);
+
+// Writes p50 / p99 / max per phase as JSON when the path ends in .json,
+// otherwise as CSV. Returns 0 and prints why on failure.
+int trace_write(const FrameTrace* trace, const char* path);
+
+#else
+
+typedef struct {
+  int unused;
+} FrameTrace;
+
+static inline void trace_init(FrameTrace* trace) { (void)trace; }
+static inline void trace_attach(FrameTrace* trace, Game* game) {
+  (void)trace;
+  (void)game;
+}
+static inline LatencyHist* trace_input_hist(FrameTrace* trace) {
+  (void)trace;
+  return NULL;
+}
+static inline void trace_frame_begin(FrameTrace* trace) { (void)trace; }
+static inline void trace_phase(FrameTrace* trace, FramePhase phase) {
+  (void)trace;
+  (void)phase;
+}
+static inline void trace_phase_begin(FrameTrace* trace) { (void)trace; }
+static inline void trace_frame_end(FrameTrace* trace) { (void)trace; }
+static inline void trace_bytes(FrameTrace* trace, size_t bytes) {
+  (void)trace;
+  (void)bytes;
+}
+static inline void trace_merge(FrameTrace* trace, const FrameTrace* from) {
+  (void)trace;
+  (void)from;
+}
+static inline int trace_toggle_overlay(FrameTrace* trace) {
+  (void)trace;
+  return 0;
+}
+static inline void trace_overlay_text(FrameTrace* trace, SnapshotText* text) {
+  (void)trace;
+  text->count = 0;
+}
+static inline void trace_append_overlay(FrameTrace* trace,
+                                        SnapshotText* text) {
+  (void)trace;
+  (void)text;
+}
+int trace_write(const FrameTrace* trace, const char* path);
+
+#endif
+
+#endif
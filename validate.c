@@ -0,0 +1,23 @@
+#include "validate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void (*game_on_fatal)(void) = NULL;
+
+void validate_ptr(void* ptr, const char* name) {
+  // Check if the pointer is NULL
+  if (ptr == NULL) {
+    // Let the frontend restore the terminal before printing the error message
+    if (game_on_fatal) {
+      game_on_fatal();
+    }
+
+    // Print an error message to stderr indicating the pointer is NULL,
+    // including the pointer's name
+    fprintf(stderr, "Error: NULL pointer detected in %s\n", name);
+
+    // Exit the program with failure status (EXIT_FAILURE)
+    exit(EXIT_FAILURE);
+  }
+}
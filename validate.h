@@ -0,0 +1,15 @@
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+// Called by validate_ptr before the process exits, so a frontend can restore
+// the terminal first
+extern void (*game_on_fatal)(void);
+
+// Validates a pointer and prints an error message with the pointer's name if
+// it's NULL
+void validate_ptr(void* ptr, const char* name);
+
+// Macro to validate a pointer and print its name if NULL.
+#define VALIDATE(ptr) validate_ptr(ptr, #ptr)
+
+#endif
@@ -0,0 +1,189 @@
+#define _XOPEN_SOURCE 700
+
+#include "workers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Carves the scratch space for the game's current layout, again whenever
+// the game was laid out for other bricks, balls or columns
+static void fit_workers(StepWorkers* workers) {
+  const Game* game = workers->game;
+  if (workers->brick_total == game->grid.total &&
+      workers->ball_capacity == game->balls.capacity &&
+      workers->width == game->win_conf.rect.w) {
+    return;
+  }
+
+  workers->brick_total = game->grid.total;
+  workers->ball_capacity = game->balls.capacity;
+  workers->width = game->win_conf.rect.w;
+
+  Arena* arena = &workers->arena;
+  arena_reset(arena);
+  size_t balls = workers->ball_capacity + 1;
+  workers->hits = arena_alloc(arena, sizeof(BrickHit) * MAX_BALL_HITS * balls);
+  workers->hit_count = arena_alloc(arena, sizeof(int) * balls);
+  workers->order = arena_alloc(arena, sizeof(int) * balls);
+  workers->column_start =
+      arena_alloc(arena, sizeof(int) * (workers->width + 2));
+  for (int t = 0; t < workers->threads; t++) {
+    init_grid_query(&workers->workers[t].query, workers->brick_total, arena);
+  }
+}
+
+// Sorts the balls by the column they are in, counting sort since the window
+// is only so wide
+static void sort_balls(StepWorkers* workers) {
+  const BallPool* balls = &workers->game->balls;
+  int width = workers->width;
+  int* start = workers->column_start;
+  memset(start, 0, sizeof(int) * (width + 2));
+
+  for (int i = 0; i < balls->count; i++) {
+    int column = FIX_TO_CELL(balls->x[i]);
+    column = column < 0 ? 0 : column > width ? width : column;
+    start[column + 1]++;
+  }
+  for (int c = 0; c <= width; c++) {
+    start[c + 1] += start[c];
+  }
+  for (int i = 0; i < balls->count; i++) {
+    int column = FIX_TO_CELL(balls->x[i]);
+    column = column < 0 ? 0 : column > width ? width : column;
+    workers->order[start[column]++] = i;
+  }
+}
+
+// Moves the balls of one run and finds what they hit
+static void find_run_hits(StepWorker* worker) {
+  StepWorkers* workers = worker->owner;
+  Game* game = workers->game;
+  BallPool* balls = &game->balls;
+  int first = (int)((long)balls->count * worker->id / workers->threads);
+  int last = (int)((long)balls->count * (worker->id + 1) / workers->threads);
+
+  for (int k = first; k < last; k++) {
+    int i = workers->order[k];
+    move_ball(balls, i, workers->step, workers->steps);
+    workers->hit_count[i] =
+        find_ball_hits(game->bricks, &game->packed, &game->grid,
+                       &worker->query, balls, i,
+                       workers->hits + (size_t)i * MAX_BALL_HITS);
+  }
+}
+
+static void* worker_thread(void* arg) {
+  StepWorker* worker = arg;
+  StepWorkers* workers = worker->owner;
+
+  // The caller holds the lock until every thread was started and the
+  // barriers were set up, or it gave up on starting them
+  pthread_mutex_lock(&workers->lock);
+  int quit = workers->quit;
+  pthread_mutex_unlock(&workers->lock);
+
+  // The barriers order the sub-step's setup before the work and the work
+  // before whatever the caller does with it
+  while (!quit) {
+    pthread_barrier_wait(&workers->start);
+    quit = workers->quit;
+    if (!quit) {
+      find_run_hits(worker);
+      pthread_barrier_wait(&workers->done);
+    }
+  }
+  return NULL;
+}
+
+int step_workers_start(StepWorkers* workers, Game* game, int threads) {
+  memset(workers, 0, sizeof(*workers));
+  workers->game = game;
+  workers->threads = threads > 0 ? threads : 1;
+  workers->brick_total = -1;
+
+  size_t size = sizeof(StepWorker) * workers->threads;
+  workers->workers = aligned_alloc(alignof(StepWorker), size);
+  VALIDATE(workers->workers);
+  memset(workers->workers, 0, size);
+  arena_init(&workers->arena, 0);
+  fit_workers(workers);
+
+  pthread_mutex_init(&workers->lock, NULL);
+  pthread_mutex_lock(&workers->lock);
+  int started = 1;
+  for (; started < workers->threads; started++) {
+    StepWorker* worker = &workers->workers[started];
+    worker->owner = workers;
+    worker->id = started;
+    int err = pthread_create(&worker->thread, NULL, worker_thread, worker);
+    if (err != 0) {
+      fprintf(stderr, "Error: cannot start step thread %d: %s\n", started,
+              strerror(err));
+      break;
+    }
+  }
+  workers->workers[0].owner = workers;
+
+  int ok = started == workers->threads;
+  workers->quit = !ok;
+  if (ok) {
+    pthread_barrier_init(&workers->start, NULL, workers->threads);
+    pthread_barrier_init(&workers->done, NULL, workers->threads);
+  }
+  pthread_mutex_unlock(&workers->lock);
+
+  if (!ok) {
+    for (int t = 1; t < started; t++) {
+      pthread_join(workers->workers[t].thread, NULL);
+    }
+    pthread_mutex_destroy(&workers->lock);
+    arena_free(&workers->arena);
+    free(workers->workers);
+    workers->workers = NULL;
+    return 0;
+  }
+
+  game->workers = workers;
+  return 1;
+}
+
+void step_workers_stop(StepWorkers* workers) {
+  if (workers->workers == NULL) {
+    return;
+  }
+  workers->game->workers = NULL;
+
+  workers->quit = 1;
+  pthread_barrier_wait(&workers->start);
+  for (int t = 1; t < workers->threads; t++) {
+    pthread_join(workers->workers[t].thread, NULL);
+  }
+
+  pthread_barrier_destroy(&workers->start);
+  pthread_barrier_destroy(&workers->done);
+  pthread_mutex_destroy(&workers->lock);
+  arena_free(&workers->arena);
+  free(workers->workers);
+  workers->workers = NULL;
+}
+
+void step_workers_find_hits(StepWorkers* workers, int step, int steps) {
+  fit_workers(workers);
+  workers->step = step;
+  workers->steps = steps;
+
+  if (workers->threads == 1) {
+    for (int i = 0; i < workers->game->balls.count; i++) {
+      workers->order[i] = i;
+    }
+    find_run_hits(&workers->workers[0]);
+    return;
+  }
+
+  sort_balls(workers);
+  pthread_barrier_wait(&workers->start);
+  find_run_hits(&workers->workers[0]);
+  pthread_barrier_wait(&workers->done);
+}
@@ -0,0 +1,68 @@
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include <pthread.h>
+#include <stdalign.h>
+
+#include "arena.h"
+#include "game.h"
+
+// A thread's share of the ball passes, kept a cache line apart from the
+// others since each one stamps its own query for every ball
+typedef struct {
+  alignas(64) GridQuery query;
+  pthread_t thread;
+  struct StepWorkers* owner;
+  int id;
+} StepWorker;
+
+// Threads that move the balls of a sub-step and find the bricks they hit.
+// The balls are sorted by column and dealt out in runs of as many balls
+// each, so a thread mostly reads the bricks above its own columns; the runs
+// follow the balls rather than fixed strips of the board, which keeps the
+// threads even when the balls bunch up. A ball at the edge of a run is
+// looked at against every brick it touches, whichever run they lie in:
+// finding only reads the board. The hits are then applied on one thread in
+// ball order, which makes the game the same as the serial step's for any
+// number of threads. Keeping the balls in bounds, the drops, the paddle and
+// the ball updates stay on the calling thread too.
+typedef struct StepWorkers {
+  Game* game;
+  int threads;
+  StepWorker* workers;  // the first one is the calling thread's
+  pthread_mutex_t lock;  // held while the threads are started
+  pthread_barrier_t start;
+  pthread_barrier_t done;
+  int quit;
+
+  // Carved for a round's brick count, ball capacity and window width, and
+  // carved again when the game is laid out anew
+  Arena arena;
+  int brick_total;
+  int ball_capacity;
+  int width;
+
+  BrickHit* hits;  // MAX_BALL_HITS for every ball
+  int* hit_count;
+  int* order;  // ball indices sorted by column
+  int* column_start;
+
+  // The sub-step being worked on
+  int step;
+  int steps;
+} StepWorkers;
+
+// Starts threads - 1 threads to share the ball passes of game with the
+// caller, and hands them to game_step. Returns 0 and prints why when they
+// cannot be started.
+int step_workers_start(StepWorkers* workers, Game* game, int threads);
+
+// Takes the workers off the game and joins their threads
+void step_workers_stop(StepWorkers* workers);
+
+// Moves every ball through sub-step step of steps and finds the bricks it
+// hit, into workers->hits and workers->hit_count. Blocks until every thread
+// is done.
+void step_workers_find_hits(StepWorkers* workers, int step, int steps);
+
+#endif